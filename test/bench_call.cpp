@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "benchmark.hpp"
+
+namespace {
+
+struct point
+{
+	int x = 0;
+
+	int get() const { return x; }
+	void add(int dx) { x += dx; }
+};
+
+} // unnamed namespace
+
+void bench_call()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<point> point_class(isolate);
+	point_class
+		.use_class_constructor<>()
+		.set("add", &point::add)
+		.set("get", &point::get)
+		;
+
+	// the same members bound with wrap_function_template,
+	// unwrapping `this` through the class registry on each call
+	v8::Local<v8::ObjectTemplate> proto =
+		point_class.class_function_template()->PrototypeTemplate();
+	proto->Set(isolate, "add_lookup",
+		v8pp::wrap_function_template(isolate, &point::add));
+	proto->Set(isolate, "get_lookup",
+		v8pp::wrap_function_template(isolate, &point::get));
+
+	context.set("point", point_class);
+	run_script<int>(context, "p = new point(); 0");
+
+	size_t const count = 1000000;
+	bench_script(context, "method call, registry lookup", count, "p.add_lookup(1);");
+	bench_script(context, "method call, bound singleton", count, "p.add(1);");
+	bench_script(context, "const method call, registry lookup", count, "p.get_lookup();");
+	bench_script(context, "const method call, bound singleton", count, "p.get();");
+
+	check_eq("point.x", run_script<int>(context, "p.get()"), static_cast<int>(2 * count));
+}
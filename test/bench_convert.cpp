@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/context.hpp"
+#include "v8pp/convert.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace {
+
+// element recording the peak count of handles during a conversion
+struct handle_probe
+{
+	static int peak;
+	int value;
+};
+
+int handle_probe::peak = 0;
+
+} // unnamed namespace
+
+namespace v8pp {
+
+template<>
+struct convert<handle_probe>
+{
+	using from_type = handle_probe;
+	using to_type = v8::Handle<v8::Number>;
+
+	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
+	{
+		return !value.IsEmpty() && value->IsNumber();
+	}
+
+	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		int const handles = v8::HandleScope::NumberOfHandles(isolate);
+		if (handles > handle_probe::peak)
+		{
+			handle_probe::peak = handles;
+		}
+		return handle_probe{ convert<int>::from_v8(isolate, value) };
+	}
+
+	static to_type to_v8(v8::Isolate* isolate, handle_probe const& value)
+	{
+		return convert<int>::to_v8(isolate, value.value);
+	}
+};
+
+template<>
+struct is_wrapped_class<handle_probe> : std::false_type {};
+
+} // namespace v8pp
+
+namespace {
+
+template<typename T>
+void bench_roundtrip(v8::Isolate* isolate, char const* name, size_t count, T const& value)
+{
+	v8::HandleScope scope(isolate);
+	v8::Local<v8::Value> converted;
+	bench((std::string(name) + " to_v8").c_str(), count, [&]()
+	{
+		converted = v8pp::to_v8(isolate, value);
+	});
+	T result;
+	bench((std::string(name) + " from_v8").c_str(), count, [&]()
+	{
+		result = v8pp::from_v8<T>(isolate, converted);
+	});
+	check(name, result == value);
+}
+
+} // unnamed namespace
+
+void bench_convert()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	size_t const count = 1000000;
+
+	std::vector<double> const doubles(count, 1.5);
+	std::vector<int> const ints(count, 42);
+	bench_roundtrip(isolate, "vector<double> Array", count, doubles);
+	bench_roundtrip(isolate, "vector<int> Array", count, ints);
+	bench_roundtrip(isolate, "vector<double> Float64Array", count,
+		v8pp::typed_array<double>(doubles));
+
+	// 1000 x 100 objects of 4 properties
+	std::map<std::string, int> const object = { { "a", 1 }, { "b", 2 }, { "c", 3 }, { "d", 4 } };
+	std::vector<std::vector<std::map<std::string, int>>> const objects(1000,
+		std::vector<std::map<std::string, int>>(100, object));
+	bench_roundtrip(isolate, "vector<vector<map>>", objects.size() * 100, objects);
+
+	// 32^4 numbers 4 levels deep
+	using level1 = std::vector<int>;
+	using level2 = std::vector<level1>;
+	using level3 = std::vector<level2>;
+	using level4 = std::vector<level3>;
+	level4 const deep(32, level3(32, level2(32, level1(32, 7))));
+	bench_roundtrip(isolate, "4-level nested vector", 32 * 32 * 32 * 32, deep);
+
+	// handles are released after each chunk of elements
+	v8::Local<v8::Value> const numbers = v8pp::to_v8(isolate, ints);
+	int const handles = v8::HandleScope::NumberOfHandles(isolate);
+	handle_probe::peak = 0;
+	bench("vector<handle_probe> from_v8", count, [&]()
+	{
+		v8pp::from_v8<std::vector<handle_probe>>(isolate, numbers);
+	});
+	std::cout << "\n  peak handles: " << handle_probe::peak - handles;
+	check("bounded handles", handle_probe::peak - handles
+		<= 2 * v8pp::detail::conversion_chunk_size);
+}
@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/ptr_map.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace {
+
+struct item
+{
+	int64_t value = 0;
+};
+
+size_t const live_counts[] = { 10000, 100000, 1000000, 10000000 };
+
+struct record
+{
+	void* handle;
+	int flags;
+};
+
+template<typename Map>
+void bench_map(char const* name, std::vector<item> const& items)
+{
+	std::string const prefix = std::string(name) + " " + std::to_string(items.size());
+	Map map;
+	bench((prefix + " insert").c_str(), items.size(), [&]()
+	{
+		for (item const& it : items) map.emplace(&it, record{ nullptr, 0 });
+	});
+	size_t found = 0;
+	bench((prefix + " find").c_str(), items.size(), [&]()
+	{
+		for (item const& it : items) found += map.find(&it) != map.end();
+	});
+	check_eq("found", found, items.size());
+	bench((prefix + " erase").c_str(), items.size(), [&]()
+	{
+		for (item const& it : items) map.erase(&it);
+	});
+}
+
+// std::unordered_map interface adapter for ptr_map
+struct ptr_map_adapter : v8pp::detail::ptr_map<record>
+{
+	record* end() const { return nullptr; }
+};
+
+void bench_wrapped(v8::Isolate* isolate, std::vector<item>& items)
+{
+	std::string const prefix = "class_ " + std::to_string(items.size());
+	size_t const chunk = 1000;
+
+	bench((prefix + " wrap").c_str(), items.size(), [&]()
+	{
+		for (size_t i = 0; i < items.size(); i += chunk)
+		{
+			v8::HandleScope scope(isolate);
+			for (size_t j = i; j < std::min(i + chunk, items.size()); ++j)
+			{
+				v8pp::class_<item>::reference_external(isolate, &items[j]);
+			}
+		}
+	});
+
+	size_t found = 0;
+	bench((prefix + " unwrap").c_str(), items.size(), [&]()
+	{
+		for (size_t i = 0; i < items.size(); i += chunk)
+		{
+			v8::HandleScope scope(isolate);
+			for (size_t j = i; j < std::min(i + chunk, items.size()); ++j)
+			{
+				v8::Local<v8::Object> obj =
+					v8pp::class_<item>::find_object(isolate, &items[j]);
+				found += v8pp::class_<item>::unwrap_object(isolate, obj) == &items[j];
+			}
+		}
+	});
+	check_eq("unwrapped", found, items.size());
+
+	bench((prefix + " remove").c_str(), items.size(), [&]()
+	{
+		v8::HandleScope scope(isolate);
+		for (item& it : items)
+		{
+			v8pp::class_<item>::remove_object(isolate, &it);
+		}
+	});
+}
+
+// Return chunk objects to JavaScript as an array, one by one and in bulk
+void bench_wrap_array(v8::Isolate* isolate, std::vector<item>& items)
+{
+	std::string const prefix = "class_ " + std::to_string(items.size());
+	size_t const chunk = 10000;
+
+	std::vector<item*> ptrs;
+	for (item& it : items) ptrs.push_back(&it);
+
+	bench((prefix + " wrap to array one by one").c_str(), items.size(), [&]()
+	{
+		for (size_t i = 0; i < ptrs.size(); i += chunk)
+		{
+			v8::HandleScope scope(isolate);
+			v8::Local<v8::Context> context = isolate->GetCurrentContext();
+			size_t const count = std::min(chunk, ptrs.size() - i);
+			v8::Local<v8::Array> arr = v8::Array::New(isolate, static_cast<int>(count));
+			for (size_t j = 0; j < count; ++j)
+			{
+				arr->Set(context, static_cast<uint32_t>(j),
+					v8pp::class_<item>::reference_external(isolate, ptrs[i + j])).FromJust();
+			}
+		}
+	});
+	v8pp::class_<item>::remove_objects(isolate);
+
+	bench((prefix + " wrap to array in bulk").c_str(), items.size(), [&]()
+	{
+		for (size_t i = 0; i < ptrs.size(); i += chunk)
+		{
+			v8::HandleScope scope(isolate);
+			size_t const count = std::min(chunk, ptrs.size() - i);
+			v8::Local<v8::Array> arr = v8pp::class_<item>::reference_externals(isolate,
+				ptrs.begin() + i, ptrs.begin() + i + count);
+			check_eq("bulk array length", arr->Length(), count);
+		}
+	});
+	v8pp::class_<item>::remove_objects(isolate);
+}
+
+struct owned_item
+{
+	std::vector<char> payload = std::vector<char>(32);
+};
+
+// Destroy objects owned by wrappers with cleanup() and with teardown()
+// of an isolate which is disposed next
+void bench_teardown(size_t count)
+{
+	std::string const prefix = "class_ " + std::to_string(count);
+	size_t const chunk = 10000;
+
+	for (bool fast : { false, true })
+	{
+		v8pp::context context;
+		v8::Isolate* isolate = context.isolate();
+		v8::HandleScope scope(isolate);
+		v8::Local<v8::Context> v8_context = isolate->GetCurrentContext();
+
+		v8pp::class_<owned_item> owned_class(isolate);
+		owned_class.set_thread_safe_destroy(true);
+
+		// keep the wrappers reachable, so that GC doesn't take them
+		v8::Local<v8::Array> all = v8::Array::New(isolate);
+		std::vector<owned_item*> ptrs;
+		for (size_t i = 0; i < count; i += chunk)
+		{
+			v8::HandleScope chunk_scope(isolate);
+			ptrs.clear();
+			for (size_t j = i; j < std::min(count, i + chunk); ++j)
+			{
+				ptrs.push_back(new owned_item);
+			}
+			all->Set(v8_context, static_cast<uint32_t>(i / chunk),
+				v8pp::class_<owned_item>::import_externals(isolate, ptrs.begin(), ptrs.end())).FromJust();
+		}
+
+		v8pp::teardown_stats stats{};
+		bench((prefix + (fast? " teardown" : " cleanup")).c_str(), count, [&]()
+		{
+			if (fast)
+			{
+				stats = v8pp::teardown(isolate);
+			}
+			else
+			{
+				v8pp::cleanup(isolate);
+			}
+		});
+		if (fast)
+		{
+			check_eq("teardown objects", stats.objects, count);
+			std::cout << " threads " << stats.threads << ", unlink " << stats.unlink_ms
+				<< " ms, destroy " << stats.destroy_ms << " ms";
+		}
+	}
+}
+
+} // unnamed namespace
+
+void bench_object_registry()
+{
+	for (size_t count : live_counts)
+	{
+		std::vector<item> items(count);
+		bench_map<std::unordered_map<void const*, record>>("std::unordered_map", items);
+		bench_map<ptr_map_adapter>("v8pp::detail::ptr_map", items);
+	}
+
+	for (size_t count : live_counts)
+	{
+		bench_teardown(count);
+	}
+
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<item> item_class(isolate);
+	for (size_t count : live_counts)
+	{
+		std::vector<item> items(count);
+		bench_wrapped(isolate, items);
+		bench_wrap_array(isolate, items);
+	}
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/slab_pool.hpp"
+
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace {
+
+struct heap_point
+{
+	double x, y;
+	heap_point(double x, double y) : x(x), y(y) {}
+	double len2() const { return x * x + y * y; }
+};
+
+struct pooled_point
+{
+	double x, y;
+	pooled_point(double x, double y) : x(x), y(y) {}
+	double len2() const { return x * x + y * y; }
+};
+
+// Allocate and free batches of small objects, as wrappers do on churn
+void bench_allocators(size_t count)
+{
+	size_t const batch = 1000;
+	std::vector<heap_point*> heap(batch);
+	bench("new/delete", count, [&]()
+	{
+		for (size_t i = 0; i < count; i += batch)
+		{
+			for (heap_point*& p : heap) p = new heap_point(1, 2);
+			for (heap_point* p : heap) delete p;
+		}
+	});
+
+	v8pp::detail::slab_pool pool(sizeof(pooled_point));
+	std::vector<pooled_point*> pooled(batch);
+	bench("slab_pool", count, [&]()
+	{
+		for (size_t i = 0; i < count; i += batch)
+		{
+			for (pooled_point*& p : pooled) p = new (pool.allocate()) pooled_point(1, 2);
+			for (pooled_point* p : pooled) { p->~pooled_point(); pool.deallocate(p); }
+		}
+	});
+}
+
+} // unnamed namespace
+
+void bench_pool_allocator()
+{
+	size_t const count = 1000000;
+	bench_allocators(count);
+
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<heap_point> heap_class(isolate);
+	heap_class
+		.use_class_constructor<double, double>()
+		.set("len2", &heap_point::len2)
+		;
+	v8pp::class_<pooled_point> pooled_class(isolate);
+	pooled_class
+		.use_pool_allocator()
+		.use_class_constructor<double, double>()
+		.set("len2", &pooled_point::len2)
+		;
+	context.set("heap_point", heap_class);
+	context.set("pooled_point", pooled_class);
+
+	// short-lived objects, freed by the garbage collector
+	bench_script(context, "churn, new/delete", count,
+		"new heap_point(i, 1).len2();");
+	bench_script(context, "churn, pool allocator", count,
+		"new pooled_point(i, 1).len2();");
+
+	v8pp::class_<heap_point>::remove_objects(isolate);
+	v8pp::class_<pooled_point>::remove_objects(isolate);
+}
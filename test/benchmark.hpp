@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "test.hpp"
+
+/// Run f() once and report its time per each of count operations
+template<typename F>
+double bench(char const* name, size_t count, F&& f)
+{
+	using clock = std::chrono::steady_clock;
+
+	clock::time_point const start = clock::now();
+	f();
+	std::chrono::duration<double, std::nano> const elapsed = clock::now() - start;
+
+	double const ns_per_op = count? elapsed.count() / count : 0.0;
+	std::cout << "\n  " << name << ": " << ns_per_op << " ns/op ("
+		<< count << " ops, " << elapsed.count() / 1e6 << " ms)";
+	return ns_per_op;
+}
+
+/// Run script statement count times in a JavaScript loop
+inline double bench_script(v8pp::context& context, char const* name,
+	size_t count, std::string const& statement)
+{
+	std::string const source = "for (var i = 0; i < " + std::to_string(count)
+		+ "; ++i) { " + statement + " } 0";
+	return bench(name, count, [&context, &source]()
+	{
+		run_script<int>(context, source);
+	});
+}
@@ -23,6 +23,7 @@ void run_tests()
 	void test_utility();
 	void test_context();
 	void test_convert();
+	void test_external_string();
 	void test_throw_ex();
 	void test_call_v8();
 	void test_call_from_v8();
@@ -30,15 +31,28 @@ void run_tests()
 	void test_factory();
 	void test_module();
 	void test_class();
+	void test_class_stats();
+	void test_external_memory();
+	void test_class_registry();
+	void test_class_hierarchy();
+	void test_class_function();
+	void test_wrap_range();
+	void test_value_wrapping();
+	void test_destruction_queue();
+	void test_inline_storage();
+	void test_owned_buffer();
 	void test_property();
 	void test_object();
 	void test_json();
+	void test_ptr_map();
+	void test_slab_pool();
 
 	std::pair<char const*, void(*)()> tests[] =
 	{
 		{ "test_utility", test_utility },
 		{ "test_context", test_context },
 		{ "test_convert", test_convert },
+		{ "test_external_string", test_external_string },
 		{ "test_throw_ex", test_throw_ex },
 		{ "test_function", test_function },
 		{ "test_call_v8", test_call_v8 },
@@ -46,9 +60,21 @@ void run_tests()
 		{ "test_factory", test_factory },
 		{ "test_module", test_module },
 		{ "test_class", test_class },
+		{ "test_class_stats", test_class_stats },
+		{ "test_external_memory", test_external_memory },
+		{ "test_class_registry", test_class_registry },
+		{ "test_class_hierarchy", test_class_hierarchy },
+		{ "test_class_function", test_class_function },
+		{ "test_wrap_range", test_wrap_range },
+		{ "test_value_wrapping", test_value_wrapping },
+		{ "test_destruction_queue", test_destruction_queue },
+		{ "test_inline_storage", test_inline_storage },
+		{ "test_owned_buffer", test_owned_buffer },
 		{ "test_property", test_property },
 		{ "test_object", test_object },
 		{ "test_json", test_json },
+		{ "test_ptr_map", test_ptr_map },
+		{ "test_slab_pool", test_slab_pool },
 	};
 
 	for (auto const& test : tests)
@@ -68,11 +94,43 @@ void run_tests()
 	}
 }
 
+void run_benchmarks()
+{
+	void bench_call();
+	void bench_convert();
+	void bench_object_registry();
+	void bench_pool_allocator();
+
+	std::pair<char const*, void(*)()> benchmarks[] =
+	{
+		{ "bench_call", bench_call },
+		{ "bench_convert", bench_convert },
+		{ "bench_object_registry", bench_object_registry },
+		{ "bench_pool_allocator", bench_pool_allocator },
+	};
+
+	for (auto const& benchmark : benchmarks)
+	{
+		std::cout << benchmark.first;
+		try
+		{
+			benchmark.second();
+		}
+		catch (std::exception const& ex)
+		{
+			std::cerr << " error: " << ex.what();
+			exit(EXIT_FAILURE);
+		}
+		std::cout << std::endl;
+	}
+}
+
 int main(int argc, char const * argv[])
 {
 	std::vector<std::string> scripts;
 	std::string lib_path;
 	bool do_tests = false;
+	bool do_benchmarks = false;
 
 	for (int i = 1; i < argc; ++i)
 	{
@@ -85,6 +143,7 @@ int main(int argc, char const * argv[])
 				<< "  --version,-v        Print V8 version\n"
 				<< "  --lib-path <dir>    Set <dir> for plugins library path\n"
 				<< "  --run-tests         Run library tests\n"
+				<< "  --run-benchmarks    Run library benchmarks\n"
 				;
 			return EXIT_SUCCESS;
 		}
@@ -101,6 +160,10 @@ int main(int argc, char const * argv[])
 		{
 			do_tests = true;
 		}
+		else if (arg == "--run-benchmarks")
+		{
+			do_benchmarks = true;
+		}
 		else
 		{
 			scripts.push_back(arg);
@@ -113,11 +176,16 @@ int main(int argc, char const * argv[])
 	v8::V8::InitializePlatform(platform.get());
 	v8::V8::Initialize();
 
-	if (do_tests || scripts.empty())
+	if (do_tests || (scripts.empty() && !do_benchmarks))
 	{
 		run_tests();
 	}
 
+	if (do_benchmarks)
+	{
+		run_benchmarks();
+	}
+
 	int result = EXIT_SUCCESS;
 	try
 	{
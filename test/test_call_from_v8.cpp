@@ -32,6 +32,29 @@ void w(v8::FunctionCallbackInfo<v8::Value> const& args)
 	return args.GetReturnValue().Set(args.Length());
 }
 
+double sum(v8pp::array_view<double const> values)
+{
+	double result = 0;
+	for (double v : values)
+	{
+		result += v;
+	}
+	return result;
+}
+
+void scale(v8pp::array_view<float> values, float k)
+{
+	for (float& v : values)
+	{
+		v *= k;
+	}
+}
+
+size_t byte_count(v8pp::array_view<uint8_t> const& bytes)
+{
+	return bytes.size();
+}
+
 using v8pp::detail::select_call_traits;
 using v8pp::detail::call_from_v8_traits;
 using v8pp::detail::isolate_arg_call_traits;
@@ -77,4 +100,21 @@ void test_call_from_v8()
 	check_eq("y", run_script<int>(context, "y(1)"), 1);
 	check_eq("z", run_script<int>(context, "z(2)"), 2);
 	check_eq("w", run_script<int>(context, "w(2, 'd', true, null)"), 4);
+
+	context.set("sum", v8pp::wrap_function(isolate, "sum", &sum));
+	context.set("scale", v8pp::wrap_function(isolate, "scale", &scale));
+	context.set("byte_count", v8pp::wrap_function(isolate, "byte_count", &byte_count));
+
+	check_eq("array_view", run_script<double>(context,
+		"sum(new Float64Array([1, 2, 3.5]))"), 6.5);
+	check_eq("array_view of subarray", run_script<double>(context,
+		"sum(new Float64Array([1, 2, 3.5]).subarray(1))"), 5.5);
+	check_eq("array_view modified", run_script<float>(context,
+		"a = new Float32Array([1, 2]); scale(a, 3); a[0] + a[1]"), 9.0f);
+	check_eq("array_view of ArrayBuffer", run_script<int>(context,
+		"byte_count(new ArrayBuffer(16))"), 16);
+	check_eq("array_view of DataView", run_script<int>(context,
+		"byte_count(new DataView(new ArrayBuffer(16), 4))"), 12);
+	check_eq("array_view wrong type", run_script<std::string>(context,
+		"try { sum([1, 2]) } catch (e) { e.message }"), "expected Float64Array");
 }
@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct widget
+{
+	int get() const { return 1; }
+};
+
+} // unnamed namespace
+
+void test_class_function()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<widget> widget_class(isolate);
+	widget_class.set("get", &widget::get);
+	auto& singleton = v8pp::detail::class_singletons::find_class<widget>(isolate);
+
+	// the function is instantiated once in a context
+	v8::Local<v8::Context> const first = isolate->GetCurrentContext();
+	v8::Local<v8::Function> const first_func = singleton.class_function(first);
+	check("reused in context", singleton.class_function(first) == first_func);
+	check_eq("cached contexts", singleton.cached_function_count(), 1u);
+
+	// each context has its own function
+	{
+		v8::HandleScope second_scope(isolate);
+		v8::Local<v8::Context> const second = v8::Context::New(isolate);
+		v8::Local<v8::Function> const second_func = singleton.class_function(second);
+		check("distinct in contexts", second_func != first_func);
+		check("reused in other context", singleton.class_function(second) == second_func);
+		check("first context still cached", singleton.class_function(first) == first_func);
+		check_eq("cached contexts", singleton.cached_function_count(), 2u);
+	}
+
+	// the cache doesn't keep the second context alive, its entry
+	// is dropped on the next miss
+	std::string const v8_flags = "--expose_gc";
+	v8::V8::SetFlagsFromString(v8_flags.data(), (int)v8_flags.length());
+	isolate->ContextDisposedNotification();
+	isolate->RequestGarbageCollectionForTesting(
+		v8::Isolate::GarbageCollectionType::kFullGarbageCollection);
+
+	v8::Local<v8::Context> const third = v8::Context::New(isolate);
+	check("new context function", singleton.class_function(third) != first_func);
+	check_eq("collected context dropped", singleton.cached_function_count(), 2u);
+	check("first context after drop", singleton.class_function(first) == first_func);
+}
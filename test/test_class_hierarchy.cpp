@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <memory>
+
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+// padding bases give the other bases non-zero offsets
+struct pad1 { int p1 = 0; virtual ~pad1() {} };
+struct pad2 { int p2 = 0; virtual ~pad2() {} };
+
+struct grand
+{
+	int g = 1;
+	int get_g() const { return g; }
+	virtual ~grand() {}
+};
+struct base : pad1, grand { int b = 2; };
+struct derived : pad2, base { int d = 3; };
+
+struct vgrand { int vg = 4; virtual ~vgrand() {} };
+struct vbase : pad1, virtual vgrand { int vb = 5; };
+struct vderived : pad2, vbase { int vd = 6; };
+struct vbase2 : pad2, virtual vgrand { int vb2 = 7; };
+
+} // unnamed namespace
+
+void test_class_hierarchy()
+{
+	derived d, d2;
+	vderived vd;
+	vbase2 vb2;
+
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<grand> grand_class(isolate);
+	grand_class.set("g", &grand::g).set("get_g", &grand::get_g);
+	v8pp::class_<base> base_class(isolate);
+	base_class.inherit<grand>().set("b", &base::b);
+	v8pp::class_<derived> derived_class(isolate);
+	derived_class.inherit<base>().use_class_constructor<>().set("d", &derived::d);
+
+	v8pp::class_<vgrand> vgrand_class(isolate);
+	vgrand_class.set("vg", &vgrand::vg);
+	v8pp::class_<vbase> vbase_class(isolate);
+	vbase_class.virtually_inherit<vgrand>().set("vb", &vbase::vb);
+	v8pp::class_<vderived> vderived_class(isolate);
+	vderived_class.inherit<vbase>().set("vd", &vderived::vd);
+	v8pp::class_<vbase2> vbase2_class(isolate);
+	vbase2_class.inherit<vgrand>().set("vb2", &vbase2::vb2);
+
+	// non-virtual bases, the whole path is a constant offset
+	v8::Local<v8::Object> d_obj = v8pp::class_<derived>::reference_external(isolate, &d);
+	check("derived", v8pp::class_<derived>::unwrap_object(isolate, d_obj) == &d);
+	check("base of derived", v8pp::class_<base>::unwrap_object(isolate, d_obj)
+		== static_cast<base*>(&d));
+	check("grand base of derived", v8pp::class_<grand>::unwrap_object(isolate, d_obj)
+		== static_cast<grand*>(&d));
+	check("grand base offset", static_cast<void*>(static_cast<grand*>(&d))
+		!= static_cast<void*>(&d));
+
+	// virtual grand base, the path has a cast step
+	v8::Local<v8::Object> vd_obj = v8pp::class_<vderived>::reference_external(isolate, &vd);
+	check("vderived", v8pp::class_<vderived>::unwrap_object(isolate, vd_obj) == &vd);
+	check("base of vderived", v8pp::class_<vbase>::unwrap_object(isolate, vd_obj)
+		== static_cast<vbase*>(&vd));
+	check("virtual grand base of vderived", v8pp::class_<vgrand>::unwrap_object(isolate, vd_obj)
+		== static_cast<vgrand*>(&vd));
+
+	// a virtual base bound with inherit<U>()
+	v8::Local<v8::Object> vb2_obj = v8pp::class_<vbase2>::reference_external(isolate, &vb2);
+	check("virtual base of vbase2", v8pp::class_<vgrand>::unwrap_object(isolate, vb2_obj)
+		== static_cast<vgrand*>(&vb2));
+	check("vbase2", v8pp::class_<vbase2>::unwrap_object(isolate, vb2_obj) == &vb2);
+
+	// members of grand bases are reached through the same casts
+	context.set("d", d_obj);
+	context.set("vd", vd_obj);
+	check_eq("grand base member", run_script<int>(context, "d.g + d.b + d.d"), 6);
+	check_eq("virtual grand base member", run_script<int>(context, "vd.vg + vd.vb + vd.vd"), 15);
+	d.g = 10;
+	vd.vg = 40;
+	check_eq("grand base member changed", run_script<int>(context, "d.g"), 10);
+	check_eq("virtual grand base member changed", run_script<int>(context, "vd.vg"), 40);
+
+	v8pp::class_<derived>::remove_object(isolate, &d);
+	v8pp::class_<vderived>::remove_object(isolate, &vd);
+	v8pp::class_<vbase2>::remove_object(isolate, &vb2);
+
+	// access flags of a const wrapper are checked for any class
+	// the object is unwrapped as
+	v8::Local<v8::Object> const_obj =
+		v8pp::class_<derived>::reference_const_external(isolate, &d);
+	check("const unwrapped", v8pp::class_<derived>::unwrap_const_object(isolate, const_obj) == &d);
+	check("const unwrapped as grand base", v8pp::class_<grand>::unwrap_const_object(isolate, const_obj)
+		== static_cast<grand const*>(&d));
+	check_ex<std::runtime_error>("const not unwrapped for non-const access", [isolate, const_obj]()
+	{
+		v8pp::class_<derived>::unwrap_object(isolate, const_obj);
+	});
+	check_ex<std::runtime_error>("const not unwrapped as grand base for non-const access",
+		[isolate, const_obj]()
+	{
+		v8pp::class_<grand>::unwrap_object(isolate, const_obj);
+	});
+	v8pp::class_<derived>::remove_object(isolate, &d);
+
+	// an object is wrapped once, whatever class of its hierarchy and
+	// subobject address it is wrapped with
+	grand* g2 = &d2;
+	v8pp::class_<grand>::reference_external(isolate, g2);
+	check("wrapped grand base found from derived",
+		v8pp::class_<derived>::object_already_wrapped(isolate, &d2));
+	check_ex<std::runtime_error>("derived of wrapped grand base", [isolate, &d2]()
+	{
+		v8pp::class_<derived>::reference_external(isolate, &d2);
+	});
+	v8pp::class_<grand>::remove_object(isolate, g2);
+	check("removed grand base not found from derived",
+		!v8pp::class_<derived>::object_already_wrapped(isolate, &d2));
+
+	v8pp::class_<derived>::reference_external(isolate, &d2);
+	check("wrapped derived found from grand base",
+		v8pp::class_<grand>::object_already_wrapped(isolate, g2));
+	check_ex<std::runtime_error>("grand base of wrapped derived", [isolate, g2]()
+	{
+		v8pp::class_<grand>::reference_external(isolate, g2);
+	});
+	v8pp::class_<derived>::remove_object(isolate, &d2);
+	check("removed derived not found from grand base",
+		!v8pp::class_<grand>::object_already_wrapped(isolate, g2));
+
+	// shared pointers to bases share ownership with the wrapped object
+	std::shared_ptr<derived> const shared = std::make_shared<derived>();
+	v8::Local<v8::Object> shared_obj = v8pp::class_<derived>::wrap_shared_object(isolate, shared);
+	long const use_count = shared.use_count();
+	{
+		std::shared_ptr<grand> const shared_grand =
+			v8pp::class_<grand>::unwrap_shared_object(isolate, shared_obj);
+		check("shared grand base", shared_grand.get() == static_cast<grand*>(shared.get()));
+		check("shared grand base owner", !shared_grand.owner_before(shared)
+			&& !shared.owner_before(shared_grand));
+		check_eq("shared grand base use count", shared.use_count(), use_count + 1);
+	}
+	check_eq("shared grand base released", shared.use_count(), use_count);
+	v8pp::class_<derived>::remove_object(isolate, shared.get());
+	check_eq("shared released by wrapper", shared.use_count(), 1);
+
+	// JavaScript objects derived from wrappers are unwrapped
+	// through their prototypes
+	context.set("derived", derived_class);
+	check_eq("JavaScript subclass", run_script<int>(context,
+		"class sub extends derived { constructor() { super(); } };"
+		"s = new sub(); s.get_g() + s.b + s.d"), 6);
+	check_eq("Object.create", run_script<int>(context,
+		"o = Object.create(s); o.get_g() + o.d"), 4);
+	check_eq("Object.create changed", run_script<int>(context,
+		"o.d = 5; s.d"), 5);
+}
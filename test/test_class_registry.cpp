@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct slotted
+{
+	int get() const { return 1; }
+};
+
+} // unnamed namespace
+
+void test_class_registry()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	// type_info of the class in another module has another slot index
+	using v8pp::detail::class_singletons;
+	v8pp::detail::type_info const other = v8pp::detail::make_type_info<slotted>();
+	v8pp::class_<slotted> slotted_class(isolate);
+	slotted_class
+		.use_class_constructor<>()
+		.set("get", &slotted::get)
+		;
+	context.set("slotted", slotted_class);
+	check_eq("bound method", run_script<int>(context, "s = new slotted(); get = s.get; s.get()"), 1);
+	check("other index", other.index() != v8pp::detail::type_id<slotted>().index());
+	v8pp::detail::class_info* info = class_singletons::find_class_info(isolate, other);
+	check("found by other index", info && info->type() == other);
+	check("found by own index", class_singletons::find_class_info(isolate,
+		v8pp::detail::type_id<slotted>()) == info);
+
+	v8pp::class_<slotted>::remove(isolate);
+	check("removed by other index", !class_singletons::find_class_info(isolate, other));
+	check("removed", !class_singletons::find_class_info(isolate,
+		v8pp::detail::type_id<slotted>()));
+	check_ex<std::runtime_error>("bound method of removed class", [&context]()
+	{
+		run_script<int>(context, "s.get()");
+	});
+
+	// the registry of the isolate is removed with its last class,
+	// methods bound before find the class registered again
+	v8pp::class_<slotted> registered_again(isolate);
+	registered_again.use_class_constructor<>();
+	context.set("slotted", registered_again);
+	check_eq("bound method of class registered again",
+		run_script<int>(context, "get.call(new slotted())"), 1);
+}
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class_stats_module.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct counted
+{
+	int value = 1;
+	int get() const { return value; }
+};
+
+struct shared_counted
+{
+	int value = 2;
+};
+
+} // unnamed namespace
+
+void test_class_stats()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<counted> counted_class(isolate);
+	counted_class
+		.use_class_constructor<>()
+		.set_object_size_func([](counted const*) { return size_t(100); })
+		.set("get", &counted::get)
+		;
+	v8pp::class_<shared_counted> shared_class(isolate);
+	shared_class.use_class_constructor_with_shared_ptr<>();
+
+	context.set("counted", counted_class);
+	context.set("shared_counted", shared_class);
+
+	run_script<int>(context, "a = new counted(); b = new counted(); "
+		"c = new shared_counted(); a.get() + b.get()");
+
+	v8pp::class_stats stats = v8pp::class_<counted>::stats(isolate);
+	check_eq("live", stats.live, 2u);
+	check_eq("peak", stats.peak, 2u);
+	check_eq("owned", stats.owned, 2u);
+	check_eq("shared", stats.shared, 0u);
+	check_eq("wraps", stats.wraps, 2u);
+	check_eq("unwraps", stats.unwraps, 2u);
+	check_eq("external bytes", stats.external_bytes, 200);
+
+	counted* a = v8pp::class_<counted>::unwrap_object(isolate,
+		context.run_script("a"));
+	v8pp::class_<counted>::remove_object(isolate, a);
+	stats = v8pp::class_<counted>::stats(isolate);
+	check_eq("live after remove", stats.live, 1u);
+	check_eq("peak after remove", stats.peak, 2u);
+	check_eq("removals", stats.removals, 1u);
+	check_eq("external bytes after remove", stats.external_bytes, 100);
+
+	stats = v8pp::class_<shared_counted>::stats(isolate);
+	check_eq("shared live", stats.live, 1u);
+	check_eq("shared", stats.shared, 1u);
+	check_eq("shared owned", stats.owned, 0u);
+
+	v8pp::reset_class_stats(isolate);
+	stats = v8pp::class_<counted>::stats(isolate);
+	check_eq("wraps after reset", stats.wraps, 0u);
+	check_eq("peak after reset", stats.peak, 1u);
+
+	check_eq("class stats count", v8pp::get_class_stats(isolate).size(), 2u);
+
+	context.set("stats", v8pp::class_stats_module::init(isolate));
+	check_eq("stats module live", run_script<int>(context,
+		"stats.classes()['" + v8pp::detail::type_id<counted>().name() + "'].live"), 1);
+	check_eq("stats module wraps", run_script<int>(context,
+		"new counted(); stats.classes()['" + v8pp::detail::type_id<counted>().name() + "'].wraps"), 1);
+	run_script<int>(context, "stats.reset(); 0");
+	check_eq("stats module external memory", run_script<int>(context,
+		"var m = stats.externalMemory(); m.reported + m.pending"), 200);
+}
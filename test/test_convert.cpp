@@ -69,6 +69,21 @@ struct person
 	}
 };
 
+namespace custom {
+
+// converted by an overload found with argument dependent lookup
+struct counter
+{
+	int value;
+};
+
+v8::Local<v8::Value> to_v8(v8::Isolate* isolate, counter const& c)
+{
+	return v8pp::to_v8(isolate, c.value);
+}
+
+} // namespace custom
+
 namespace v8pp {
 
 template<>
@@ -142,11 +157,94 @@ void test_convert()
 	test_string_conv(isolate, L"qaz");
 #endif
 
+	// short strings are written into the inline buffer, long ones
+	// into the heap or right into the result
+	std::string const utf8 = "\xD0\xBA\xD0\xBB\xD1\x8E\xD1\x87 \xE2\x82\xAC";
+	std::string const long_str = std::string(200, 'x') + utf8;
+	test_conv(isolate, utf8);
+	test_conv(isolate, long_str);
+	check_eq("UTF-8 string resized to the written bytes", v8pp::from_v8<std::string>(isolate,
+		v8pp::to_v8(isolate, utf8)).size(), utf8.size());
+	check_eq("long string pointer", v8pp::from_v8<char const*>(isolate,
+		v8pp::to_v8(isolate, long_str)), long_str);
+	std::string const str_ptr(v8pp::from_v8<char const*>(isolate, v8pp::to_v8(isolate, utf8)));
+	check_eq("string pointer as std::string", str_ptr, utf8);
+	check_eq("string pointer size", v8pp::from_v8<char const*>(isolate,
+		v8pp::to_v8(isolate, utf8)).size(), utf8.size());
+	check_eq("long UTF-16 string pointer", v8pp::from_v8<uint16_t const*>(isolate,
+		v8pp::to_v8(isolate, long_str)).size(), 206u);
+	check_eq("UTF-16 string", v8pp::from_v8<std::basic_string<uint16_t>>(isolate,
+		v8pp::to_v8(isolate, utf8)).size(), 6u);
+
+	v8pp::string_view const view = "qaz";
+	check("string_view", v8pp::from_v8<v8pp::string_view>(isolate,
+		v8pp::to_v8(isolate, view)) == view);
+	check("long string_view", v8pp::from_v8<v8pp::string_view>(isolate,
+		v8pp::to_v8(isolate, long_str)) == v8pp::string_view(long_str));
+
+	// ASCII and latin1 strings are moved into external ones, others copied
+	v8pp::external_string ascii(std::string(1000, 'a'));
+	v8::Local<v8::String> ext = v8pp::convert_result_to_v8<v8pp::external_string>
+		::result_to_v8(isolate, ascii);
+	check("external ASCII", ext->IsExternalOneByte() && ascii.str().empty());
+	check_eq("external ASCII content", v8pp::from_v8<std::string>(isolate, ext),
+		std::string(1000, 'a'));
+	v8pp::external_string latin1("caf\xE9", v8pp::external_string::latin1);
+	ext = v8pp::convert_result_to_v8<v8pp::external_string>::result_to_v8(isolate, latin1);
+	check("external latin1", ext->IsExternalOneByte() && ext->Length() == 4);
+	check_eq("external latin1 content", v8pp::from_v8<std::string>(isolate, ext),
+		"caf\xC3\xA9");
+	ext = v8pp::to_v8(isolate, v8pp::external_string(utf8));
+	check("UTF-8 not external", !ext->IsExternal());
+	check_eq("UTF-8 content", v8pp::from_v8<std::string>(isolate, ext), utf8);
+	ext = v8pp::to_v8(isolate, v8pp::external_u16string(
+		v8pp::from_v8<std::basic_string<uint16_t>>(isolate, v8pp::to_v8(isolate, utf8))));
+	check("external UTF-16", ext->IsExternal());
+	check_eq("external UTF-16 content", v8pp::from_v8<std::string>(isolate, ext), utf8);
+	std::string long_result(2 * 1024 * 1024, 'a');
+	ext = v8pp::convert_result_to_v8<std::string>::result_to_v8(isolate, long_result);
+	check("long result external", ext->IsExternal() == (V8PP_EXTERNAL_STRING_THRESHOLD > 0));
+	check_eq("long result length", ext->Length(), 2 * 1024 * 1024);
+
+	// external strings alive at the isolate disposal are disposed by V8,
+	// their memory is detached from the isolate before
+	std::shared_ptr<v8pp::detail::external_string_memory> memory;
+	{
+		v8pp::context disposed;
+		v8::Isolate* disposed_isolate = disposed.isolate();
+		v8::HandleScope disposed_scope(disposed_isolate);
+		disposed.set("str", v8pp::to_v8(disposed_isolate,
+			v8pp::external_string(std::string(1000, 'b'))));
+		memory = v8pp::detail::external_string_memory::find(disposed_isolate);
+		check("external string memory", memory != nullptr && memory->bytes() == 1000);
+	}
+	check("external string memory detached", memory->isolate() == nullptr);
+	check_eq("external string disposed with the isolate", memory->bytes(), 0);
+
 	using int_vector = std::vector<int>;
 
 	int_vector vector = { 1, 2, 3 };
 	test_conv(isolate, vector);
 
+	// numbers in typed arrays are copied at once
+	v8pp::typed_array<double> doubles = { 1.5, 2.5, 3.5 };
+	test_conv(isolate, doubles);
+	check("Float64Array", v8pp::to_v8(isolate, doubles)->IsFloat64Array());
+	check_eq("Float64Array to vector", v8pp::from_v8<std::vector<double>>(isolate,
+		v8pp::to_v8(isolate, doubles)), std::vector<double>(doubles));
+	check_eq("Int32Array to vector", v8pp::from_v8<int_vector>(isolate,
+		v8pp::to_typed_array(isolate, vector)), vector);
+	check_eq("Int32Array to vector<double>", v8pp::from_v8<std::vector<double>>(isolate,
+		v8pp::to_typed_array(isolate, vector)), std::vector<double>({ 1, 2, 3 }));
+	check("Float32Array", v8pp::to_typed_array(isolate, std::vector<float>(10))->Length() == 10);
+	check_eq("Uint8Array to array", (v8pp::from_v8<std::array<uint8_t, 2>>(isolate,
+		v8pp::to_typed_array(isolate, std::array<uint8_t, 2>{ { 7, 8 } }))[1]), 8);
+	check_ex<std::runtime_error>("wrong typed array length", [isolate]()
+	{
+		v8pp::from_v8<std::array<float, 2>>(isolate,
+			v8pp::to_typed_array(isolate, std::vector<float>(3)));
+	});
+
 	std::map<char, int> map = { { 'a', 1 }, { 'b', 2 }, { 'c', 3 } };
 	test_conv(isolate, map);
 
@@ -167,6 +265,9 @@ void test_convert()
 	std::list<int> list = { 1, 2, 3 };
 	check_eq("pair of iterators to array", v8pp::from_v8<int_vector>(isolate,
 		v8pp::to_v8(isolate, list.begin(), list.end())), vector);
+	std::vector<custom::counter> const counters = { { 1 }, { 2 }, { 3 } };
+	check_eq("iterators of to_v8 overload", v8pp::from_v8<int_vector>(isolate,
+		v8pp::to_v8(isolate, counters.begin(), counters.end())), vector);
 
 	person p;
 	p.name = "Al"; p.age = 33;
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/destruction_queue.hpp"
+
+#include <atomic>
+#include <string>
+
+#include "test.hpp"
+
+namespace {
+
+std::atomic<int> destroyed(0);
+
+void destroy_int(void*, void* object, bool)
+{
+	delete static_cast<int*>(object);
+	++destroyed;
+}
+
+struct deferred
+{
+	static std::atomic<int> instance_count;
+	deferred() { ++instance_count; }
+	~deferred() { --instance_count; }
+};
+
+std::atomic<int> deferred::instance_count(0);
+
+void test_queue()
+{
+	using v8pp::detail::destruction_queue;
+
+	destroyed = 0;
+	{
+		destruction_queue queue;
+		for (int i = 0; i < 10; ++i)
+		{
+			queue.push(&destroy_int, nullptr, new int(i), false, nullptr, false);
+		}
+		check_eq("depth", queue.depth(), 10u);
+		check_eq("destroyed before drain", destroyed.load(), 0);
+
+		check_eq("partial drain", queue.drain(4), 4u);
+		check_eq("destroyed after partial drain", destroyed.load(), 4);
+		check_eq("depth after partial drain", queue.depth(), 6u);
+
+		// shared objects are released from the queue
+		std::shared_ptr<int> shared = std::make_shared<int>(42);
+		std::weak_ptr<int> weak = shared;
+		queue.push(nullptr, nullptr, shared.get(), false, std::move(shared), false);
+		check("shared alive in queue", !weak.expired());
+
+		check_eq("drain all", queue.drain(), 7u);
+		check("shared released", weak.expired());
+
+		for (int i = 0; i < 100; ++i)
+		{
+			queue.push(&destroy_int, nullptr, new int(i), false, nullptr, true);
+		}
+		queue.flush();
+		check_eq("background destroyed", destroyed.load(), 110);
+
+		v8pp::destruction_queue_stats const stats = queue.stats();
+		check_eq("stats depth", stats.depth, 0u);
+		check_eq("stats background depth", stats.background_depth, 0u);
+		check("stats peak depth", stats.peak_depth >= 11);
+		check_eq("stats enqueued", stats.enqueued, 111u);
+		check_eq("stats destroyed", stats.destroyed, 111u);
+		check("stats latency", stats.max_latency_ms >= stats.avg_latency_ms);
+
+		// the rest is destroyed with the queue
+		queue.push(&destroy_int, nullptr, new int(0), false, nullptr, false);
+		queue.push(&destroy_int, nullptr, new int(0), false, nullptr, true);
+	}
+	check_eq("destroyed with queue", destroyed.load(), 112);
+}
+
+void test_deferred_class()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<deferred> deferred_class(isolate);
+	deferred_class
+		.use_deferred_destruction()
+		.use_class_constructor<>()
+		;
+	context.set("deferred", deferred_class);
+
+	run_script<int>(context, "for (i = 0; i < 10; ++i) new deferred(); i");
+	check_eq("instances", deferred::instance_count.load(), 10);
+
+	std::string const v8_flags = "--expose_gc";
+	v8::V8::SetFlagsFromString(v8_flags.data(), (int)v8_flags.length());
+	isolate->RequestGarbageCollectionForTesting(
+		v8::Isolate::GarbageCollectionType::kFullGarbageCollection);
+
+	v8pp::destruction_queue_stats stats = v8pp::get_destruction_queue_stats(isolate);
+	check_eq("unlinked after GC", v8pp::class_<deferred>::num_objects(isolate), 0u);
+	check_eq("alive after GC", deferred::instance_count.load(), int(stats.depth));
+	check_eq("enqueued after GC", stats.enqueued, stats.depth);
+
+	v8pp::drain_destruction_queue(isolate);
+	check_eq("alive after drain", deferred::instance_count.load(), 0);
+	stats = v8pp::get_destruction_queue_stats(isolate);
+	check_eq("depth after drain", stats.depth, 0u);
+	check_eq("destroyed after drain", stats.destroyed, stats.enqueued);
+}
+
+void test_teardown()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<deferred> deferred_class(isolate);
+	deferred_class
+		.set_thread_safe_destroy(true)
+		.use_class_constructor<>()
+		;
+	context.set("deferred", deferred_class);
+
+	int const count = 10000;
+	run_script<int>(context, "var all = []; "
+		"for (i = 0; i < " + std::to_string(count) + "; ++i) all.push(new deferred()); i");
+	check_eq("instances before teardown", deferred::instance_count.load(), count);
+
+	v8pp::teardown_stats const stats = v8pp::teardown(isolate, 2);
+	check_eq("instances after teardown", deferred::instance_count.load(), 0);
+	check_eq("teardown classes", stats.classes, 1u);
+	check_eq("teardown objects", stats.objects, size_t(count));
+	check_eq("teardown threads", stats.threads, 2u);
+	check("teardown time", stats.total_ms >= stats.unlink_ms + stats.destroy_ms);
+
+	// wrappers collected after teardown don't call back into the class
+	run_script<int>(context, "all = null; 0");
+	std::string const v8_flags = "--expose_gc";
+	v8::V8::SetFlagsFromString(v8_flags.data(), (int)v8_flags.length());
+	isolate->RequestGarbageCollectionForTesting(
+		v8::Isolate::GarbageCollectionType::kFullGarbageCollection);
+	check_eq("instances after GC", deferred::instance_count.load(), 0);
+}
+
+} // unnamed namespace
+
+void test_destruction_queue()
+{
+	test_queue();
+	test_deferred_class();
+	test_teardown();
+}
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct blob
+{
+	char data[16];
+};
+
+} // unnamed namespace
+
+void test_external_memory()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::external_memory_stats stats = v8pp::get_external_memory_stats(isolate);
+	check("no classes", stats.reported == 0 && stats.pending == 0 && stats.threshold == 0);
+
+	// the threshold may be set before any class is registered
+	v8pp::set_external_memory_threshold(isolate, 500);
+	check_eq("threshold without classes", v8pp::get_external_memory_stats(isolate).threshold, 500);
+
+	v8pp::class_<blob> blob_class(isolate);
+	blob_class.set_object_size_func([](blob const*) -> size_t { return 100; });
+	check_eq("threshold kept for classes", v8pp::get_external_memory_stats(isolate).threshold, 500);
+
+	// the pending amount is reported when it crosses the threshold
+	v8pp::set_external_memory_threshold(isolate, 250);
+	blob* blobs[4] = { new blob, new blob, new blob, new blob };
+	v8pp::class_<blob>::import_external(isolate, blobs[0]);
+	v8pp::class_<blob>::import_external(isolate, blobs[1]);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending below threshold", stats.pending, 200);
+	check_eq("reported below threshold", stats.reported, 0);
+	check_eq("threshold", stats.threshold, 250);
+
+	v8pp::class_<blob>::import_external(isolate, blobs[2]);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending reported at threshold", stats.pending, 0);
+	check_eq("reported at threshold", stats.reported, 300);
+
+	// and on explicit flush
+	v8pp::class_<blob>::import_external(isolate, blobs[3]);
+	check_eq("pending before flush", v8pp::get_external_memory_stats(isolate).pending, 100);
+	v8pp::flush_external_memory(isolate);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending after flush", stats.pending, 0);
+	check_eq("reported after flush", stats.reported, 400);
+
+	// removals are batched the same way
+	v8pp::class_<blob>::remove_object(isolate, blobs[0]);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending removal", stats.pending, -100);
+	check_eq("reported before removal flush", stats.reported, 400);
+	v8pp::class_<blob>::remove_objects(isolate);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending removals reported", stats.pending, 0);
+	check_eq("all removed", stats.reported, 0);
+
+	// lowering the threshold reports the pending amount
+	v8pp::class_<blob>::import_external(isolate, new blob);
+	v8pp::set_external_memory_threshold(isolate, 0);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check_eq("pending with zero threshold", stats.pending, 0);
+	check_eq("reported with zero threshold", stats.reported, 100);
+
+	// removal of the remaining objects is reported to the isolate when the
+	// class is removed, the registry keeps the threshold set for the isolate
+	v8pp::class_<blob>::import_external(isolate, new blob);
+	v8pp::set_external_memory_threshold(isolate, 1000);
+	v8pp::class_<blob>::remove(isolate);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check("removal reported", stats.reported == 0 && stats.pending == 0);
+	check_eq("threshold kept without classes", stats.threshold, 1000);
+
+	v8pp::class_<blob> blob_class2(isolate);
+	blob_class2.set_object_size_func([](blob const*) -> size_t { return 100; });
+	check_eq("threshold kept for new classes", v8pp::get_external_memory_stats(isolate).threshold, 1000);
+	v8pp::class_<blob>::import_external(isolate, new blob);
+	check_eq("pending with kept threshold", v8pp::get_external_memory_stats(isolate).pending, 100);
+
+	// the registry with the threshold is removed on cleanup, before the
+	// isolate disposal
+	v8pp::cleanup(isolate);
+	stats = v8pp::get_external_memory_stats(isolate);
+	check("registry removed", stats.reported == 0 && stats.pending == 0 && stats.threshold == 0);
+
+	// the default threshold doesn't keep the registry without classes
+	v8pp::class_<blob> blob_class3(isolate);
+	check_eq("default threshold", v8pp::get_external_memory_stats(isolate).threshold,
+		int64_t(v8pp::detail::external_memory::default_threshold));
+	v8pp::class_<blob>::remove(isolate);
+	check_eq("registry removed with default threshold",
+		v8pp::get_external_memory_stats(isolate).threshold, 0);
+}
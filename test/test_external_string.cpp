@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#define V8PP_EXTERNAL_STRING_THRESHOLD 1024
+
+#include "v8pp/context.hpp"
+#include "v8pp/convert.hpp"
+
+#include <memory>
+#include <string>
+
+#include "test.hpp"
+
+namespace {
+
+// Other test files use the default threshold, a string type of this file
+// only keeps its result_to_v8() instantiation apart from theirs
+template<typename T>
+struct local_allocator : std::allocator<T>
+{
+	template<typename U> struct rebind { using other = local_allocator<U>; };
+
+	local_allocator() = default;
+	template<typename U> local_allocator(local_allocator<U> const&) {}
+};
+
+using local_string = std::basic_string<char, std::char_traits<char>, local_allocator<char>>;
+
+} // unnamed namespace
+
+void test_external_string()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	using convert_result = v8pp::convert_result_to_v8<local_string>;
+
+	local_string result(2048, 'a');
+	v8::Local<v8::String> str = convert_result::result_to_v8(isolate, result);
+	check("long result external", str->IsExternalOneByte());
+	check("long result moved", result.empty());
+	check_eq("long result content", v8pp::from_v8<std::string>(isolate, str),
+		std::string(2048, 'a'));
+
+	result.assign(1024, 'b');
+	str = convert_result::result_to_v8(isolate, result);
+	check("threshold result external", str->IsExternal() && result.empty());
+
+	result.assign(1023, 'c');
+	str = convert_result::result_to_v8(isolate, result);
+	check("short result not external", !str->IsExternal());
+	check_eq("short result length", str->Length(), 1023);
+
+	// non-ASCII UTF-8 is copied
+	result.assign(2048, 'd');
+	result.replace(0, 2, "\xC3\xA9");
+	str = convert_result::result_to_v8(isolate, result);
+	check("UTF-8 result not external", !str->IsExternal());
+	check_eq("UTF-8 result length", str->Length(), 2047);
+
+	// only results are moved, arguments to to_v8() are copied
+	result.assign(2048, 'e');
+	str = v8pp::to_v8(isolate, result);
+	check("long value not external", !str->IsExternal() && result.size() == 2048);
+}
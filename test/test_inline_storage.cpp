@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/function.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct vec3
+{
+	float x, y, z;
+
+	vec3() : x(0), y(0), z(0) {}
+	vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+	float dot(vec3 const& other) const { return x * other.x + y * other.y + z * other.z; }
+	void scale(float k) { x *= k; y *= k; z *= k; }
+};
+
+vec3 cross(vec3 const& a, vec3 const& b)
+{
+	return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+} // unnamed namespace
+
+void test_inline_storage()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<vec3> vec3_class(isolate);
+	vec3_class
+		.use_inline_storage()
+		.use_class_constructor<float, float, float>()
+		.set("x", &vec3::x)
+		.set("y", &vec3::y)
+		.set("z", &vec3::z)
+		.set("dot", &vec3::dot)
+		.set("scale", &vec3::scale)
+		;
+	context.set("vec3", vec3_class);
+	context.set("cross", v8pp::wrap_function(isolate, "cross", &cross));
+
+	check_eq("constructed", run_script<float>(context,
+		"a = new vec3(1, 2, 3); a.x + a.y + a.z"), 6.0f);
+	check_eq("method", run_script<float>(context,
+		"b = new vec3(4, 5, 6); a.dot(b)"), 32.0f);
+	check_eq("modified in place", run_script<float>(context,
+		"a.scale(2); a.z"), 6.0f);
+	check_eq("returned by value", run_script<float>(context,
+		"c = cross(new vec3(1, 0, 0), new vec3(0, 1, 0)); c.z"), 1.0f);
+
+	vec3 const* a = v8pp::class_<vec3>::unwrap_const_object(isolate,
+		context.run_script("a"));
+	check("unwrapped", a && a->x == 2 && a->y == 4 && a->z == 6);
+	check("inline object not removed",
+		!v8pp::class_<vec3>::try_remove_object(isolate, const_cast<vec3*>(a)));
+	check_eq("inline object after failed removal", run_script<float>(context, "a.x"), 2.0f);
+
+	v8pp::class_stats const stats = v8pp::class_<vec3>::stats(isolate);
+	check_eq("not registered", v8pp::class_<vec3>::num_objects(isolate), 0u);
+	check_eq("not live", stats.live, 0u);
+	check_eq("wraps", stats.wraps, 5u);
+}
@@ -40,4 +40,28 @@ void test_object()
 	double pi;
 	check("get obj.pi", v8pp::get_option(isolate, obj, "pi", pi));
 	check("obj.pi", abs(pi - 3.1415926) < 10e-6);
+
+	// program names are internalized once per isolate, others each time
+	v8::Local<v8::String> const name = v8pp::name(isolate, "sub");
+	check("name internalized", name->StrictEquals(v8pp::to_v8(isolate, "sub")));
+	check("runtime name", v8pp::name(isolate, "sub.x", 3)->StrictEquals(name));
+#if defined(V8PP_ISOLATE_DATA_SLOT)
+	using v8pp::detail::isolate_data;
+	check("name cached", name == v8pp::name(isolate, "sub"));
+	v8pp::get_option(isolate, obj, "sub.x", x);
+	size_t const names = isolate_data::get(isolate)->names.size();
+	for (int i = 0; i < 1000; ++i)
+	{
+		std::string const path = "sub" + std::to_string(i) + ".x";
+		v8pp::get_option(isolate, obj, "sub.x", x);
+		v8pp::get_option(isolate, obj, path.c_str(), x);
+		v8pp::set_option(isolate, obj, "a", i);
+		v8pp::name(isolate, std::to_string(i));
+	}
+	check_eq("runtime names not cached", isolate_data::get(isolate)->names.size(), names);
+	v8pp::clear_names(isolate);
+	check("names cleared", !isolate_data::get(isolate)
+		|| isolate_data::get(isolate)->names.size() == 0);
+#endif
+	check("name after clear", v8pp::name(isolate, "sub")->StrictEquals(name));
 }
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/function.hpp"
+#include "v8pp/owned_buffer.hpp"
+
+#include <string>
+
+#include "test.hpp"
+
+namespace {
+
+int freed = 0;
+
+void free_bytes(void* data, void*)
+{
+	delete[] static_cast<char*>(data);
+	++freed;
+}
+
+v8pp::owned_buffer make_bytes(int size)
+{
+	std::vector<uint8_t> bytes(size);
+	for (int i = 0; i < size; ++i)
+	{
+		bytes[i] = static_cast<uint8_t>(i);
+	}
+	return v8pp::owned_buffer(std::move(bytes));
+}
+
+v8pp::owned_buffer make_custom()
+{
+	char* data = new char[4];
+	std::memcpy(data, "abcd", 4);
+	return v8pp::owned_buffer(data, 4, &free_bytes);
+}
+
+v8pp::owned_buffer make_doubles()
+{
+	return v8pp::owned_buffer(std::vector<double>{ 1.5, 2.5 });
+}
+
+} // unnamed namespace
+
+void test_owned_buffer()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	context.set("make_bytes", v8pp::wrap_function(isolate, "make_bytes", &make_bytes));
+	context.set("make_custom", v8pp::wrap_function(isolate, "make_custom", &make_custom));
+	context.set("make_doubles", v8pp::wrap_function(isolate, "make_doubles", &make_doubles));
+
+	check_eq("bytes", run_script<int>(context,
+		"a = new Uint8Array(make_bytes(1000)); a.length + a[999]"), 1000 + 231);
+	check_eq("custom", run_script<std::string>(context,
+		"String.fromCharCode.apply(null, new Uint8Array(make_custom()))"), "abcd");
+	check_eq("doubles", run_script<double>(context,
+		"new Float64Array(make_doubles())[1]"), 2.5);
+
+	using v8pp::detail::external_buffers;
+	check_eq("live buffers", external_buffers::count(isolate), 3u);
+	check_eq("live bytes", external_buffers::bytes(isolate), 1000u + 4 + 16);
+
+	{
+		v8::HandleScope scope(isolate);
+		v8pp::owned_buffer const copy = v8pp::from_v8<v8pp::owned_buffer>(isolate,
+			context.run_script("a.subarray(10, 20)"));
+		check_eq("copied from view", copy.size(), 10u);
+		check_eq("copied content", static_cast<uint8_t const*>(copy.data())[0], 10);
+	}
+
+	run_script<int>(context, "a = null; 0");
+	std::string const v8_flags = "--expose_gc";
+	v8::V8::SetFlagsFromString(v8_flags.data(), (int)v8_flags.length());
+	isolate->RequestGarbageCollectionForTesting(
+		v8::Isolate::GarbageCollectionType::kFullGarbageCollection);
+	check_eq("freed by GC", freed, 1);
+	check_eq("no buffers after GC", external_buffers::count(isolate), 0u);
+
+	// buffers alive on release are neutered and freed
+	run_script<int>(context, "b = make_custom(); b.byteLength");
+	v8pp::release_buffers(isolate);
+	check_eq("freed on release", freed, 2);
+	check_eq("neutered on release", run_script<int>(context, "b.byteLength"), 0);
+
+	// cleanup() releases the buffers too
+	run_script<int>(context, "c = make_custom(); c.byteLength");
+	v8pp::cleanup(isolate);
+	check_eq("freed on cleanup", freed, 3);
+	check_eq("no buffers after cleanup", external_buffers::count(isolate), 0u);
+	check_eq("neutered on cleanup", run_script<int>(context, "c.byteLength"), 0);
+
+	// teardown() frees them without neutering before the isolate disposal
+	{
+		v8pp::context disposed;
+		v8::Isolate* disposed_isolate = disposed.isolate();
+		v8::HandleScope disposed_scope(disposed_isolate);
+		disposed.set("make_custom", v8pp::wrap_function(disposed_isolate,
+			"make_custom", &make_custom));
+		run_script<int>(disposed, "d = make_custom(); d.byteLength");
+		check_eq("buffer before teardown", external_buffers::count(disposed_isolate), 1u);
+		v8pp::teardown(disposed_isolate);
+		check_eq("freed on teardown", freed, 4);
+		check_eq("no buffers after teardown", external_buffers::count(disposed_isolate), 0u);
+	}
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/ptr_map.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+void test_ptr_map()
+{
+	using v8pp::detail::ptr_map;
+
+	ptr_map<std::string> map;
+	check("empty", map.empty());
+	check("find in empty", map.find(&map) == nullptr);
+	check("erase in empty", !map.erase(&map));
+
+	// keys with the same alignment as wrapped objects
+	std::vector<int64_t> objects(10000);
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		auto result = map.emplace(&objects[i], std::to_string(i));
+		check("emplace", result.second && *result.first == std::to_string(i));
+	}
+	check_eq("size", map.size(), objects.size());
+	check("load factor", map.capacity() * 7 >= map.size() * 8);
+
+	auto dup = map.emplace(&objects[5], "dup");
+	check("emplace existing", !dup.second && *dup.first == "5");
+
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		std::string const* value = map.find(&objects[i]);
+		check("find", value && *value == std::to_string(i));
+	}
+
+	// erase every other key, the rest must stay reachable
+	for (size_t i = 0; i < objects.size(); i += 2)
+	{
+		check("erase", map.erase(&objects[i]));
+	}
+	check_eq("size after erase", map.size(), objects.size() / 2);
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		std::string const* value = map.find(&objects[i]);
+		check("find after erase", (i % 2 == 0)? value == nullptr
+			: value && *value == std::to_string(i));
+	}
+
+	size_t count = 0;
+	map.for_each([&count](void const*, std::string const&) { ++count; });
+	check_eq("for_each", count, map.size());
+
+	map.clear();
+	check("clear", map.empty() && map.find(&objects[1]) == nullptr);
+
+	// values are moved around on insert and erase
+	ptr_map<std::shared_ptr<int>> shared;
+	std::shared_ptr<int> value = std::make_shared<int>(42);
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		shared.emplace(&objects[i], value);
+	}
+	check_eq("use_count", value.use_count(), static_cast<long>(objects.size() + 1));
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		shared.erase(&objects[i]);
+	}
+	check_eq("use_count after erase", value.use_count(), 1);
+}
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+#include "v8pp/slab_pool.hpp"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "test.hpp"
+
+namespace {
+
+struct pooled
+{
+	int value;
+};
+
+struct destroyed
+{
+	int value;
+};
+
+} // unnamed namespace
+
+void test_slab_pool()
+{
+	using v8pp::detail::slab_pool;
+
+	size_t const align = slab_pool::alignment;
+	check_eq("size class of 1", slab_pool::size_class(1), align);
+	check_eq("size class of align", slab_pool::size_class(align), align);
+	check_eq("size class of align + 1", slab_pool::size_class(align + 1), 2 * align);
+
+	slab_pool pool(24);
+	check_eq("block size", pool.block_size(), slab_pool::size_class(24));
+	check_eq("initial capacity", pool.capacity(), 0u);
+
+	std::vector<void*> blocks;
+	std::set<void*> unique;
+	for (int i = 0; i < 10000; ++i)
+	{
+		void* ptr = pool.allocate();
+		check("aligned", reinterpret_cast<uintptr_t>(ptr) % align == 0);
+		blocks.push_back(ptr);
+		unique.insert(ptr);
+	}
+	check_eq("unique blocks", unique.size(), blocks.size());
+	check_eq("allocated", pool.allocated(), blocks.size());
+	check("capacity", pool.capacity() >= blocks.size());
+
+	size_t const capacity = pool.capacity();
+	for (void* ptr : blocks)
+	{
+		pool.deallocate(ptr);
+	}
+	check_eq("allocated after deallocate", pool.allocated(), 0u);
+
+	// freed blocks are reused before new slabs are added
+	for (size_t i = 0; i < blocks.size(); ++i)
+	{
+		check("reused", unique.count(pool.allocate()) == 1);
+	}
+	check_eq("capacity after reuse", pool.capacity(), capacity);
+	for (void* ptr : blocks)
+	{
+		pool.deallocate(ptr);
+	}
+
+	// pooled objects would bypass the destroy function
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	v8pp::class_<pooled> pooled_class(isolate);
+	pooled_class.use_pool_allocator();
+	check_ex<std::runtime_error>("destroy function of pooled class", [&pooled_class]()
+	{
+		pooled_class.set_destroy_func([](pooled* p) { delete p; });
+	});
+
+	v8pp::class_<destroyed> destroyed_class(isolate);
+	destroyed_class.set_destroy_func([](destroyed* p) { delete p; });
+	check_ex<std::runtime_error>("pool allocator with destroy function", [&destroyed_class]()
+	{
+		destroyed_class.use_pool_allocator();
+	});
+}
@@ -199,6 +199,30 @@ void test_is_callable()
 struct some_struct {};
 namespace test { class some_class {}; }
 
+namespace {
+
+struct base {};
+struct derived : base {};
+struct virtual_derived : virtual base {};
+struct indirect_derived : virtual_derived {};
+struct private_derived : private base {};
+struct other_derived : base {};
+struct ambiguous_derived : derived, other_derived {};
+
+using v8pp::detail::is_virtual_base_of;
+
+static_assert(!is_virtual_base_of<base, derived>::value, "non-virtual base");
+static_assert(is_virtual_base_of<base, virtual_derived>::value, "virtual base");
+static_assert(is_virtual_base_of<base, indirect_derived>::value, "indirect virtual base");
+static_assert(!is_virtual_base_of<virtual_derived, indirect_derived>::value,
+	"non-virtual base of virtual derived");
+static_assert(!is_virtual_base_of<derived, base>::value, "not a base");
+static_assert(!is_virtual_base_of<base, base>::value, "same type");
+static_assert(!is_virtual_base_of<base, private_derived>::value, "private base");
+static_assert(!is_virtual_base_of<base, ambiguous_derived>::value, "ambiguous base");
+
+} // unnamed namespace
+
 void test_utility()
 {
 	test_apply_tuple();
@@ -215,4 +239,20 @@ void test_utility()
 	check_eq("type_id", type_id<some_struct>().name(), "some_struct");
 	check_eq("type_id", type_id<test::some_class>().name(), "test::some_class");
 #endif
+
+	check("type_id equal", type_id<some_struct>() == type_id<some_struct>());
+	check("type_id not equal", type_id<some_struct>() != type_id<test::some_class>());
+	check("type_id cached", &type_id<int>() == &type_id<int>());
+	check_eq("type_id id", type_id<int>().id(), type_id<int>().id());
+
+	// another module has another type_info of the same type
+	using v8pp::detail::make_type_info;
+	check("make_type_info equal", make_type_info<some_struct>() == type_id<some_struct>());
+	check("make_type_info not equal", make_type_info<int>() != type_id<some_struct>());
+	check("make_type_info id", make_type_info<int>().id() == type_id<int>().id());
+	check("make_type_info index", make_type_info<int>().index() != type_id<int>().index());
+	check("type_id const", type_id<int const>() != type_id<int>());
+	check("type_id pointer", type_id<some_struct*>() != type_id<some_struct>());
+	check("type_id template", type_id<std::tuple<int, bool>>() != type_id<std::tuple<bool, int>>());
+	check("type_id id differs", type_id<int>().id() != type_id<bool>().id());
 }
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct point
+{
+	int x, y;
+	int sum() const { return x + y; }
+};
+
+point make_point(int x, int y) { return point{ x, y }; }
+
+} // unnamed namespace
+
+void test_value_wrapping()
+{
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	// returned values are not registered with value wrapping
+	v8pp::class_<point> point_class(isolate);
+	point_class
+		.use_value_wrapping()
+		.set("sum", &point::sum)
+		;
+	context.set("make_point", v8pp::wrap_function(isolate, "make_point", &make_point));
+	check_eq("value sum", run_script<int>(context,
+		"p = make_point(1, 2); q = make_point(3, 4); p.sum() + q.sum()"), 10);
+	v8pp::class_stats stats = v8pp::class_<point>::stats(isolate);
+	check_eq("values", stats.values, 2u);
+	check_eq("values live", stats.live, 2u);
+	check_eq("values not registered", v8pp::class_<point>::num_objects(isolate), 0u);
+	check_eq("values external bytes", stats.external_bytes,
+		static_cast<int64_t>(2 * sizeof(point)));
+	point const* p = v8pp::class_<point>::unwrap_const_object(isolate,
+		context.run_script("p"));
+	check("value unwrapped", p && p->x == 1 && p->y == 2);
+	check("value not found", v8pp::class_<point>::find_object_or_empty(isolate, p).IsEmpty());
+
+	v8pp::class_<point>::remove_object(isolate, const_cast<point*>(p));
+	check_eq("values after remove_object", v8pp::class_<point>::stats(isolate).values, 1u);
+	check_ex<std::runtime_error>("removed value not unwrapped", [&context]()
+	{
+		run_script<int>(context, "p.sum()");
+	});
+	check_eq("other value", run_script<int>(context, "q.sum()"), 7);
+	check("removed value not removed again",
+		!v8pp::class_<point>::try_remove_object(isolate, const_cast<point*>(p)));
+	point unknown{ 5, 6 };
+	check("unknown object not removed",
+		!v8pp::class_<point>::try_remove_object(isolate, &unknown));
+	check_eq("values after failed removal", v8pp::class_<point>::stats(isolate).values, 1u);
+
+	v8pp::class_<point>::remove_objects(isolate);
+	stats = v8pp::class_<point>::stats(isolate);
+	check_eq("values after remove", stats.values, 0u);
+	check_eq("external bytes after remove", stats.external_bytes, 0);
+}
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <memory>
+#include <vector>
+
+#include "v8pp/class.hpp"
+#include "v8pp/context.hpp"
+
+#include "test.hpp"
+
+namespace {
+
+struct item
+{
+	int n;
+	int get() const { return n; }
+};
+
+} // unnamed namespace
+
+void test_wrap_range()
+{
+	item refs[3] = { { 1 }, { 2 }, { 3 } };
+	item others[2] = { { 4 }, { 5 } };
+
+	v8pp::context context;
+	v8::Isolate* isolate = context.isolate();
+	v8::HandleScope scope(isolate);
+
+	using item_class = v8pp::class_<item>;
+	item_class(isolate).set("get", &item::get);
+
+	// the array has the objects in the range order
+	std::vector<item*> const ref_ptrs = { &refs[0], &refs[1], &refs[2] };
+	v8::Local<v8::Array> array = item_class::reference_externals(isolate,
+		ref_ptrs.begin(), ref_ptrs.end());
+	check_eq("references length", array->Length(), 3u);
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		check("reference order", item_class::unwrap_object(isolate, array->Get(i)) == ref_ptrs[i]);
+	}
+	context.set("refs", array);
+	check_eq("references from JavaScript",
+		run_script<int>(context, "refs[0].get() * 100 + refs[1].get() * 10 + refs[2].get()"), 123);
+
+	// the range is checked before any of its objects is wrapped
+	std::vector<item*> const duplicates = { &others[0], &others[1], &others[0] };
+	check_ex<std::runtime_error>("duplicates in range", [isolate, &duplicates]()
+	{
+		item_class::reference_externals(isolate, duplicates.begin(), duplicates.end());
+	});
+	check_eq("nothing wrapped from range with duplicates", item_class::num_objects(isolate), 3u);
+	check("first duplicate not wrapped", !item_class::object_already_wrapped(isolate, &others[0]));
+
+	std::vector<item*> const with_wrapped = { &others[0], &refs[1], &others[1] };
+	check_ex<std::runtime_error>("already wrapped in range", [isolate, &with_wrapped]()
+	{
+		item_class::reference_externals(isolate, with_wrapped.begin(), with_wrapped.end());
+	});
+	check_eq("nothing wrapped from range with wrapped", item_class::num_objects(isolate), 3u);
+	check("object before wrapped not wrapped", !item_class::object_already_wrapped(isolate, &others[0]));
+	check("object after wrapped not wrapped", !item_class::object_already_wrapped(isolate, &others[1]));
+
+	// imported objects are owned only when the whole range is wrapped
+	std::unique_ptr<item> not_imported(new item{ 6 });
+	std::vector<item*> const bad_imports = { not_imported.get(), &refs[0] };
+	check_ex<std::runtime_error>("already wrapped in imports", [isolate, &bad_imports]()
+	{
+		item_class::import_externals(isolate, bad_imports.begin(), bad_imports.end());
+	});
+	check_eq("nothing imported", item_class::num_objects(isolate), 3u);
+
+	std::vector<item*> const imports = { new item{ 7 }, new item{ 8 } };
+	array = item_class::import_externals(isolate, imports.begin(), imports.end());
+	check_eq("imports length", array->Length(), 2u);
+	check("imports order", item_class::unwrap_object(isolate, array->Get(0)) == imports[0]
+		&& item_class::unwrap_object(isolate, array->Get(1)) == imports[1]);
+	check_eq("imported", item_class::num_objects(isolate), 5u);
+
+	// shared objects are not shared with wrappers on failure
+	std::vector<std::shared_ptr<item>> const shared = {
+		std::make_shared<item>(item{ 9 }), std::make_shared<item>(item{ 10 }) };
+	std::vector<std::shared_ptr<item>> const shared_duplicates = { shared[0], shared[1], shared[0] };
+	check_ex<std::runtime_error>("duplicates in shared range", [isolate, &shared_duplicates]()
+	{
+		item_class::wrap_shared_objects(isolate, shared_duplicates.begin(), shared_duplicates.end());
+	});
+	check_eq("nothing wrapped from shared range", item_class::num_objects(isolate), 5u);
+	check_eq("not shared with wrappers", shared[0].use_count(), 3);
+
+	long const use_count = shared[1].use_count();
+	array = item_class::wrap_shared_objects(isolate, shared.begin(), shared.end());
+	check_eq("shared length", array->Length(), 2u);
+	check("shared order", item_class::unwrap_shared_object(isolate, array->Get(0)) == shared[0]
+		&& item_class::unwrap_shared_object(isolate, array->Get(1)) == shared[1]);
+	check("shared with wrapper", shared[1].use_count() > use_count);
+
+	// imported objects are destroyed, references and shared objects are not
+	item_class::remove_objects(isolate);
+	check_eq("shared released", shared[1].use_count(), use_count);
+	check_eq("references alive", refs[2].n, 3);
+}
@@ -147,6 +147,86 @@ struct call_from_v8_cpp_param_type_info
 	static void cleanup_after_call(preparation_type& /* prep */) {}
 	
 };
+
+template <typename T>
+struct is_array_view : std::false_type {};
+
+template <typename T>
+struct is_array_view<array_view<T>> : std::true_type {};
+
+/*
+  array_view<T> parameters refer to the backing store of a typed array
+  argument with T elements, for 1-byte T also of any ArrayBuffer or
+  ArrayBuffer view, without a copy. prepare() materializes the buffer of
+  a typed array allocated in the V8 heap, so the data stays in place
+  until cleanup_after_call() drops the buffer and the view.
+*/
+template <typename cpp_param_type_>
+struct call_from_v8_cpp_param_type_info
+<cpp_param_type_,
+ typename std::enable_if
+ <is_array_view<typename std::decay<cpp_param_type_>::type>::value>::type> {
+
+	using cpp_param_type = cpp_param_type_;
+
+	using view_type = typename std::decay<cpp_param_type>::type;
+	using value_type = typename view_type::value_type;
+	using element_traits = detail::typed_array_traits
+		<typename std::remove_const<value_type>::type>;
+
+	static_assert(element_traits::is_supported,
+		"array_view is for 8, 16, 32 bit integers, float and double");
+
+	struct preparation_type {
+		v8::Local<v8::ArrayBuffer> buffer;
+		view_type view;
+	};
+
+	static const int v8_param_index_advance = 1;
+
+	static preparation_type prepare(size_t v8_param_index,
+													 v8::FunctionCallbackInfo<v8::Value> const& args) {
+		v8::Local<v8::Value> value = args[v8_param_index];
+		bool const bytes = sizeof(value_type) == 1;
+
+		preparation_type prep;
+		size_t offset = 0, length = 0;
+		if (value->IsArrayBufferView()
+				&& (bytes || element_traits::is_array(value))) {
+			v8::Local<v8::ArrayBufferView> array = value.As<v8::ArrayBufferView>();
+			prep.buffer = array->Buffer();
+			offset = array->ByteOffset();
+			length = array->ByteLength();
+		}
+		else if (bytes && value->IsArrayBuffer()) {
+			prep.buffer = value.As<v8::ArrayBuffer>();
+			length = prep.buffer->ByteLength();
+		}
+		else {
+			throw std::invalid_argument(std::string("expected ")
+				+ (bytes? "ArrayBuffer or " : "") + element_traits::name());
+		}
+
+		// a neutered buffer has no data
+		char* data = static_cast<char*>(prep.buffer->GetContents().Data());
+		if (data) {
+			prep.view = view_type(reinterpret_cast<value_type*>(data + offset),
+				length / sizeof(value_type));
+		}
+		return prep;
+	}
+
+	static view_type get_param(size_t /* v8_param_index */,
+													 v8::FunctionCallbackInfo<v8::Value> const& /* args */,
+													 preparation_type& prep) {
+		return prep.view;
+	}
+
+	static void cleanup_after_call(preparation_type& prep) {
+		prep.view = view_type();
+		prep.buffer.Clear();
+	}
+};
 	
 }; // end namespace v8pp
 	
@@ -13,19 +13,31 @@
 #define V8PP_CLASS_HPP_INCLUDED
 
 #include <cstdio>
+#include <cstring>
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+#include "v8pp/class_stats.hpp"
 #include "v8pp/config.hpp"
+#include "v8pp/destruction_queue.hpp"
 //#include "v8pp/factory.hpp"
 #include "v8pp/function.hpp"
+#include "v8pp/name_cache.hpp"
+#include "v8pp/owned_buffer.hpp"
 #include "v8pp/persistent.hpp"
 #include "v8pp/property.hpp"
+#include "v8pp/ptr_map.hpp"
+#include "v8pp/slab_pool.hpp"
 
 namespace v8pp {
 
@@ -39,6 +51,9 @@ struct function_for_constructor_helper {
   static Class* construct(Args... args) {
     return new Class(std::forward<Args>(args)...);
   }
+  static Class construct_value(Args... args) {
+    return Class(std::forward<Args>(args)...);
+  }
   static std::shared_ptr<Class> construct_shared_ptr(Args...args) {
     return std::make_shared<Class>(std::forward<Args>(args)...);
   }
@@ -52,6 +67,28 @@ std::function<Class*(Args...)> get_function_for_constructor() {
      (&function_for_constructor_helper<Class, Args...>::construct));
 }
 
+template <typename Class, typename... Args>
+std::function<Class(Args...)> get_function_for_value_constructor() {
+  using ctor_type = Class (*)(Args...);
+  return std::function<Class(Args...)>
+    (static_cast<ctor_type>
+     (&function_for_constructor_helper<Class, Args...>::construct_value));
+}
+
+template <typename Class, typename... Args>
+std::function<Class*(Args...)> get_function_for_pooled_constructor(slab_pool& pool) {
+  slab_pool* p = &pool;
+  return std::function<Class*(Args...)>([p](Args... args) -> Class* {
+    void* mem = p->allocate();
+    try {
+      return new (mem) Class(std::forward<Args>(args)...);
+    } catch (...) {
+      p->deallocate(mem);
+      throw;
+    }
+  });
+}
+
 template <typename Class, typename... Args>
 std::function<std::shared_ptr<Class>(Args...)>
 get_function_for_shared_ptr_from_constructor() {
@@ -80,112 +117,256 @@ inline std::string pointer_str(void const* ptr)
 	return buf;
 }
 
+// Sizes of wrapped objects counted against the VM heap, accumulated
+// per isolate and reported to V8 in batches: one call to
+// AdjustAmountOfExternalAllocatedMemory when the pending amount
+// crosses the threshold or on flush(), instead of a call per object.
+// It doesn't flush on destruction, which may happen after the isolate
+// disposal: the owner flushes and detaches it before.
+class external_memory
+{
+public:
+	static int64_t const default_threshold = 1024 * 1024;
+
+	external_memory()
+		: isolate_(nullptr)
+		, pending_(0)
+		, reported_(0)
+		, threshold_(default_threshold)
+	{
+	}
+
+	external_memory(external_memory const&) = delete;
+	external_memory& operator=(external_memory const&) = delete;
+
+	void attach(v8::Isolate* isolate) { isolate_ = isolate; }
+
+	int64_t pending() const { return pending_; }
+	int64_t reported() const { return reported_; }
+	int64_t threshold() const { return threshold_; }
+
+	void set_threshold(int64_t threshold)
+	{
+		threshold_ = threshold;
+		adjust(0);
+	}
+
+	void adjust(int64_t delta)
+	{
+		pending_ += delta;
+		if (pending_ >= threshold_ || -pending_ >= threshold_)
+		{
+			flush();
+		}
+	}
+
+	void flush()
+	{
+		if (pending_ != 0 && isolate_)
+		{
+			isolate_->AdjustAmountOfExternalAllocatedMemory(pending_);
+			reported_ += pending_;
+			pending_ = 0;
+		}
+	}
+
+private:
+	v8::Isolate* isolate_;
+	int64_t pending_;
+	int64_t reported_;
+	int64_t threshold_;
+};
+
 class class_info
 {
 public:
 
 	using cast_function = void const* (*)(void const* ptr);
 
-	// Manages a void* which is actually a shared_ptr<T>*.
-	// Fortunately, the destruction function saved in it knows what T is,
-	// so the shared_ptr<T>* is deleted appropriately when the count
-	// goes to 0.
+	// Shared ownership of a wrapped object: shared_ptr<T> converted to
+	// shared_ptr<void>, it points to the object and shares its control
+	// block. A shared_ptr to a base class is made from it with the
+	// aliasing constructor and the raw pointer upcast, so neither
+	// storing nor unwrapping it allocates memory.
 	typedef std::shared_ptr<void> managed_shared_ptr_ptr;
-
-	using managed_shared_ptr_ptr_cast_function =
-		managed_shared_ptr_ptr (*) (const managed_shared_ptr_ptr&);
 	
 	struct object_record
 	{
 		persistent<v8::Object> v8object;
 		managed_shared_ptr_ptr shptr;
+		// size counted against the VM heap at wrap time, 0 if not counted
+		size_t external_size;
 		bool can_modify: 1;
 		bool destroy: 1;
-		bool count_against_vm_size: 1;
+		// memory of the object belongs to the class slab_pool
+		bool pooled: 1;
 
 		object_record(persistent<v8::Object>&& v8o,
 									bool can_mod,
 									bool desty,
-									bool count_against_vms):
+									size_t ext_size,
+									bool pool):
 			v8object(std::move(v8o)),
+			external_size(ext_size),
 			can_modify(can_mod),
 			destroy(desty),
-			count_against_vm_size(count_against_vms)
+			pooled(pool)
 		{;}
 
 		object_record(persistent<v8::Object>&& v8o,
 									managed_shared_ptr_ptr&& shp,
 									bool can_mod,
-									bool count_against_vm_sz):
+									size_t ext_size):
 			v8object(std::move(v8o)),
 			shptr(std::move(shp)),
+			external_size(ext_size),
 			can_modify(can_mod), 
 			destroy(false),
-			count_against_vm_size(count_against_vm_sz)
+			pooled(false)
 		{;}
 
 		bool has_shared_ptr() const { return shptr != nullptr; }
-		
+
 	};
-	
-	explicit class_info(type_info const& type) : type_(type) {}
+
+	// Internal fields of each JavaScript wrapper object
+	enum internal_field
+	{
+		object_field = 0, // pointer to the wrapped C++ object
+		class_field = 1,  // pointer to the class_info
+		flags_field = 2,  // object_flags, to unwrap without a record lookup
+		internal_field_count,
+		// ArrayBuffer with the object bytes, classes with inline storage only
+		storage_field = internal_field_count,
+		inline_internal_field_count
+	};
+
+	static bool is_wrapper(v8::Local<v8::Object> obj)
+	{
+		int const count = obj->InternalFieldCount();
+		return count == internal_field_count || count == inline_internal_field_count;
+	}
+
+	// Bits stored in flags_field, copies of the object_record bits.
+	// Bit 0 is never set: V8 accepts only aligned pointers there.
+	enum object_flags : uintptr_t
+	{
+		object_can_modify = 1 << 1,
+		object_owned = 1 << 2,
+		object_shared = 1 << 3,
+		// owned by the wrapper without a record, see use_value_wrapping()
+		object_value = 1 << 4,
+		// a value stored in the wrapper storage_field, see use_inline_storage()
+		object_inline = 1 << 5,
+	};
+
+	static uintptr_t make_object_flags(bool can_modify, bool owned, bool shared,
+		bool value = false)
+	{
+		uintptr_t flags = 0;
+		if (can_modify) flags |= object_can_modify;
+		if (owned) flags |= object_owned;
+		if (shared) flags |= object_shared;
+		if (value) flags |= object_value;
+		return flags;
+	}
+
+	static void set_object_flags(v8::Local<v8::Object> obj, uintptr_t flags)
+	{
+		assert((flags & 1) == 0);
+		obj->SetAlignedPointerInInternalField(flags_field,
+			reinterpret_cast<void*>(flags));
+	}
+
+	static uintptr_t get_object_flags(v8::Local<v8::Object> obj)
+	{
+		return reinterpret_cast<uintptr_t>(
+			obj->GetAlignedPointerFromInternalField(flags_field));
+	}
+
+	// type is type_id<T>(), which lives as long as the module
+	class_info(type_info const& type, external_memory& memory)
+		: type_(&type)
+		, external_memory_(memory)
+		, stats_()
+		, hierarchy_(std::make_shared<hierarchy>())
+	{
+		hierarchy_->classes.push_back(this);
+		update_closure();
+	}
+
 	class_info(class_info const&) = delete;
 	class_info& operator=(class_info const&) = delete;
-	virtual ~class_info() = default;
 
-	type_info const& type() const { return type_; }
+	virtual ~class_info()
+	{
+		std::vector<class_info*>& classes = hierarchy_->classes;
+		classes.erase(std::remove(classes.begin(), classes.end(), this),
+			classes.end());
+	}
+
+	type_info const& type() const { return *type_; }
 
+	// ucast is always usable. When is_virtual is false the upcast
+	// is also the constant pointer adjustment `offset`, which is used by
+	// the flattened upcast table instead of calling ucast.
 	void add_base(class_info* info,
+								bool is_virtual,
+								std::ptrdiff_t offset,
 								cast_function ucast,
-								cast_function dcast,
-								managed_shared_ptr_ptr_cast_function spucast)
+								cast_function dcast)
 	{
 		auto it = std::find_if(bases_.begin(), bases_.end(),
 			[info](base_class_info const& base) { return base.info == info; });
+		if (info == this)
+		{
+			throw std::runtime_error(class_name(*type_)
+				+ " can not inherit from itself");
+		}
 		if (it != bases_.end())
 		{
 			//assert(false && "duplicated inheritance");
-			throw std::runtime_error(class_name(type_)
-				+ " is already inherited from " + class_name(info->type_));
+			throw std::runtime_error(class_name(*type_)
+				+ " is already inherited from " + class_name(*info->type_));
 		}
-		bases_.emplace_back(info, ucast, spucast);
+		bases_.emplace_back(info, is_virtual, offset, ucast);
 		info->derivatives_.emplace_back(this, dcast);
+		update_upcasts();
+		merge_hierarchy(info);
 	}
 
 	// ptr is assumed to be a pointer to an object of "our" type.
 	// We will try to cast it to a pointer to a base class of the given type.
 	bool upcast(void const*& ptr, type_info const& type) const
 	{
-		if (type == type_ || !ptr)
+		if (&type == type_ || !ptr)
 		{
 			return true;
 		}
 
-		// fast way - search a direct parent
-		for (base_class_info const& base : bases_)
+		// all direct and indirect bases, precomputed in update_upcasts()
+		for (flat_base_info const& base : upcasts_)
 		{
-			if (base.info->type_ == type)
+			if (base.info->type_ == &type)
 			{
-				ptr = base.upcast(ptr);
+				ptr = base.cast(ptr);
 				return true;
 			}
 		}
 
-		// slower way - walk on hierarhy
-		for (base_class_info const& base : bases_)
+		// type_info of another module, compare by name
+		if (type == *type_)
 		{
-			// Manufacture a pointer of type Base*
-			void const* p = base.upcast(ptr); 
-
-			// See if we can translate that into a pointer of the target
-			// even-more-basic type
-			if (base.info->upcast(p, type))
+			return true;
+		}
+		for (flat_base_info const& base : upcasts_)
+		{
+			if (*base.info->type_ == type)
 			{
-				ptr = p;
+				ptr = base.cast(ptr);
 				return true;
 			}
 		}
-
 		return false;
 	}
 
@@ -198,142 +379,174 @@ public:
 		return false;
 	}
 	
-	managed_shared_ptr_ptr managed_shared_ptr_ptr_upcast
-	(managed_shared_ptr_ptr ptr, type_info const& type) const
+	// Make shared_ptr<U> to the object from its record, where U is the type
+	// of the class with the type info
+	template<typename U>
+	std::shared_ptr<U> shared_ptr_upcast(void* ptr, managed_shared_ptr_ptr const& shptr,
+		type_info const& type) const
 	{
-		if (type == type_ || !ptr) { return ptr; }
-		for (base_class_info const& base: bases_)
+		if (!upcast(ptr, type))
 		{
-			managed_shared_ptr_ptr base_ptr = base.managed_shared_ptr_ptr_upcast(ptr);
-			assert(base_ptr != nullptr);
-			managed_shared_ptr_ptr result =
-				base.info->managed_shared_ptr_ptr_upcast(base_ptr, type);
-			if (result != nullptr) { return result; }
+			return nullptr;
 		}
-		return nullptr;
+		return std::shared_ptr<U>(shptr, static_cast<U*>(ptr));
 	}
 	
 	template <typename T>
-	void add_object(v8::Isolate* isolate,
-									T* object,
+	void add_object(T* object,
 									persistent<v8::Object>&& handle,
 									bool can_modify,
 									bool claim_ownership,
-									bool count_against_vm_size,
-									const std::function<size_t(const T*)>& obj_size_func) {
+									size_t sz,
+									bool pooled) {
 		// exception-throwing checks moved to class_singleton so they could
 		// check to make sure no base class 
-		assert(object_records_.find(object) == object_records_.end());
+		assert(object_records_.find(object) == nullptr);
 		object_record orec(std::move(handle),
 											 can_modify,
 											 claim_ownership,
-											 count_against_vm_size);
+											 sz,
+											 pooled);
 		object_records_.emplace(object, std::move(orec));
-		if (count_against_vm_size) {
-			size_t sz = obj_size_func(object);
-			isolate->AdjustAmountOfExternalAllocatedMemory(static_cast<int64_t>(sz));
+		hierarchy_->objects.emplace(object, this);
+		if (sz) {
+			external_memory_.adjust(static_cast<int64_t>(sz));
 		}
+		count_wrap(sz);
+		stats_.owned += claim_ownership;
 	}
 	
 	template <typename T>
 	void add_shared_object
-	(v8::Isolate* isolate,
-	 std::shared_ptr<T> object,
+	(std::shared_ptr<T> object,
 	 persistent<v8::Object>&& handle,
 	 bool can_modify,
-	 bool count_against_vm_size,
-	 const std::function<size_t(const T*)>& obj_size_func)
-	{
-		assert(object_records_.find(object.get()) == object_records_.end());
-		managed_shared_ptr_ptr mspp(new std::shared_ptr<T>(object));
-		object_record orec(std::move(handle), std::move(mspp), can_modify,
-											 count_against_vm_size);
-		object_records_.emplace(object.get(), std::move(orec));
-		if (count_against_vm_size) {
-			size_t sz = obj_size_func(object.get());
-			isolate->AdjustAmountOfExternalAllocatedMemory(static_cast<int64_t>(sz));
+	 size_t sz)
+	{
+		assert(object_records_.find(object.get()) == nullptr);
+		T* ptr = object.get();
+		object_record orec(std::move(handle), std::move(object), can_modify, sz);
+		object_records_.emplace(ptr, std::move(orec));
+		hierarchy_->objects.emplace(ptr, this);
+		if (sz) {
+			external_memory_.adjust(static_cast<int64_t>(sz));
 		}
+		count_wrap(sz);
+		++stats_.shared;
 	}
 
 	bool has_shared_ptr_for_object(void* obj) {
-		auto it = object_records_.find(obj);
-		if (it == object_records_.end()) { return false; }
-		return it->second.has_shared_ptr();
+		object_record const* orec = object_records_.find(obj);
+		return orec && orec->has_shared_ptr();
 	}
 
 	bool can_modify_object(void* obj) {
-		auto it = object_records_.find(obj);
-		if (it == object_records_.end()) { return false; }
-		return it->second.can_modify;
+		object_record const* orec = object_records_.find(obj);
+		return orec && orec->can_modify;
 	}
 	
-	template <typename T>
-	void remove_object(v8::Isolate* isolate,
+	// destroy(object, pooled) is called for objects owned by their wrapper,
+	// false if the object has no record
+	template <typename T, typename Destroy>
+	bool remove_object(v8::Isolate* isolate,
 										 T* object,
-										 const std::function<void(T*)>& destroy_func,
-										 const std::function<size_t(const T*)> obj_size_func) 
+										 Destroy&& destroy_func)
 	{
-		auto it = object_records_.find(object);
-		assert(it != object_records_.end() && "no object");
-		if (it != object_records_.end())
+		object_record* orec = object_records_.find(object);
+		if (orec == nullptr)
 		{
-			if (!it->second.v8object.IsNearDeath())
-			{
-				// remove pointer to wrapped  C++ object from V8 Object internal field
-				// to disable unwrapping for this V8 Object
-				assert(to_local(isolate, it->second.v8object)->
-							 GetAlignedPointerFromInternalField(0) == object);
-				to_local(isolate, it->second.v8object)->
-					SetAlignedPointerInInternalField(0, nullptr);
-			}
-			it->second.v8object.Reset();
-			if (it->second.count_against_vm_size && (obj_size_func != nullptr))
+			return false;
+		}
+		if (!orec->v8object.IsNearDeath())
+		{
+			// remove pointer to wrapped  C++ object from V8 Object internal field
+			// to disable unwrapping for this V8 Object
+			assert(to_local(isolate, orec->v8object)->
+						 GetAlignedPointerFromInternalField(object_field) == object);
+			to_local(isolate, orec->v8object)->
+				SetAlignedPointerInInternalField(object_field, nullptr);
+		}
+		orec->v8object.Reset();
+		if (orec->external_size)
+		{
+			external_memory_.adjust(-static_cast<int64_t>(orec->external_size));
+		}
+		++stats_.removals;
+		stats_.shared -= orec->has_shared_ptr();
+		stats_.owned -= orec->destroy;
+		stats_.external_bytes -= static_cast<int64_t>(orec->external_size);
+		bool const destroy = !orec->has_shared_ptr() && orec->destroy;
+		bool const pooled = orec->pooled;
+		// erase before destroy_func: a destructor may wrap or remove
+		// other objects, which would move records around
+		object_records_.erase(object);
+		hierarchy_->objects.erase(object);
+		if (destroy) {
+			destroy_func(object, pooled);
+		}
+		return true;
+	}
+
+	template<typename T, typename Destroy>
+	void remove_objects(Destroy&& destroy_func)
+	{
+		int64_t removed_size = 0;
+		std::vector<std::pair<T*, bool>> objects;
+		objects.reserve(stats_.owned);
+		object_records_.for_each([&](void const* key, object_record& orec)
+		{
+			hierarchy_->objects.erase(key);
+			orec.v8object.Reset();
+			removed_size += static_cast<int64_t>(orec.external_size);
+			if (!orec.has_shared_ptr() && orec.destroy)
 			{
-				size_t sz = obj_size_func(object);
-				isolate->AdjustAmountOfExternalAllocatedMemory
-					(-static_cast<int64_t>(sz));
+				objects.emplace_back(static_cast<T*>(const_cast<void*>(key)), bool(orec.pooled));
 			}
-			bool has_shared_ptr = it->second.has_shared_ptr();
-			if (!has_shared_ptr && (destroy_func != nullptr) && it->second.destroy) {
-				destroy_func(object);
-			}
-			object_records_.erase(object);
+		});
+		stats_.removals += object_records_.size();
+		stats_.shared = stats_.owned = 0;
+		stats_.external_bytes = 0;
+		object_records_.clear();
+		external_memory_.adjust(-removed_size);
+
+		// destroy after the records are dropped: a destructor may wrap
+		// or remove other objects, which would change the records map
+		for (auto const& object : objects)
+		{
+			destroy_func(object.first, object.second);
 		}
 	}
 
+	// Drop all records for isolate teardown and collect the objects to
+	// destroy in objects as (pointer, pooled). Wrapper handles are reset,
+	// which drops their weak callbacks, so a later GC doesn't call back
+	// into the removed class. External memory isn't reported back and the
+	// size function isn't called. Shared objects are released here.
 	template<typename T>
-	void remove_objects(v8::Isolate* isolate,
-											const std::function<void(T*)>& destroy_func,
-											const std::function<size_t(const T*)>& obj_size_func)
-	{
-		for (auto& object_rec: object_records_)
-		{
-			bool has_shared_ptr = object_rec.second.has_shared_ptr();
-			object_rec.second.v8object.Reset();
-			T* obj = //const_cast<T*>(static_cast<T*>(object_rec.first));
-				static_cast<T*>(const_cast<void*>(object_rec.first));
-			if (object_rec.second.count_against_vm_size &&
-					(obj_size_func != nullptr))
-			{
-				size_t sz = obj_size_func(obj);
-				isolate->AdjustAmountOfExternalAllocatedMemory
-					(-static_cast<int64_t>(sz));
-			}
-			if (!has_shared_ptr && (destroy_func != nullptr) &&
-					object_rec.second.destroy)
+	void release_objects(std::vector<std::pair<T*, bool>>& objects)
+	{
+		objects.reserve(objects.size() + stats_.owned);
+		object_records_.for_each([this, &objects](void const* key, object_record& orec)
+		{
+			hierarchy_->objects.erase(key);
+			orec.v8object.Reset();
+			if (!orec.has_shared_ptr() && orec.destroy)
 			{
-				destroy_func(obj);
+				objects.emplace_back(static_cast<T*>(const_cast<void*>(key)), bool(orec.pooled));
 			}
-		}
+		});
+		stats_.removals += object_records_.size();
+		stats_.shared = stats_.owned = 0;
+		stats_.external_bytes = 0;
+		object_records_.clear();
 	}
 
+	// Destroy all objects of the class, see class_singletons::teardown()
+	virtual void teardown_objects(unsigned max_threads, teardown_stats& stats) = 0;
+
 	const object_record* find_object_record
 	(void const* object) const {
-		auto it = object_records_.find(const_cast<void*>(object));
-		if (it != object_records_.end()) {
-			return &it->second;
-		}
-		return nullptr;
+		return object_records_.find(object);
 	}
 
 	// NOTE: this only works if the pointer you pass in is already
@@ -344,9 +557,8 @@ public:
 	const object_record* find_object_record_searching_derivatives
 	(void const* object) const
 	{
-		auto it = object_records_.find(const_cast<void*>(object));
-		if (it != object_records_.end()) {
-			return &it->second;
+		if (object_record const* orec = object_records_.find(object)) {
+			return orec;
 		}
 		for (derived_class_info const& dinfo: derivatives_) {
 			const object_record* result = dinfo.info->find_object_record(object);
@@ -376,38 +588,41 @@ public:
 		return nullptr;
 	}
 
-	// Simple depth-first search through inheritance graph
-	bool pointer_already_wrapped_helper
-	(void const* object,
-	 std::unordered_set<class_info const*>& already_visited) const {
-		if (already_visited.find(this) != already_visited.end()) {
+	// Is the object, or any of its base or derived class views, wrapped
+	// by some class in our hierarchy. Uses the precomputed closure and
+	// the shared address index, so it doesn't allocate.
+	bool pointer_already_wrapped(void const* object) const {
+		ptr_map<class_info const*> const& objects = hierarchy_->objects;
+		if (objects.empty()) {
 			return false;
 		}
-		already_visited.insert(this);
-		auto it = object_records_.find(const_cast<void*>(object));
-		if (it != object_records_.end()) {
-			return true;
-		}
-		for (base_class_info const& base: bases_) {
-			void const* castobj = base.upcast(object);
-			if (base.info->pointer_already_wrapped_helper
-					(castobj, already_visited)) {
-				return true;
-			}
-		}
-		for (derived_class_info const& deriv: derivatives_) {
-			void const* castobj = deriv.downcast(object);
-			if (deriv.info->pointer_already_wrapped_helper
-					(castobj, already_visited)) {
+		for (hierarchy_node const& node: closure_) {
+			if (objects.find(node.cast(object)) != nullptr) {
 				return true;
 			}
 		}
 		return false;
 	}
 
-	bool pointer_already_wrapped(void const* object) const {
-		std::unordered_set<class_info const*> already_visited;
-		return pointer_already_wrapped_helper(object, already_visited);
+	class_stats stats() const
+	{
+		class_stats result = stats_;
+		result.name = type_->name();
+		result.live = live_objects();
+		return result;
+	}
+
+	// Reset the counters of events, start the peak from the live count
+	void reset_stats()
+	{
+		stats_.wraps = stats_.unwraps = stats_.removals = 0;
+		stats_.peak = live_objects();
+	}
+
+	// Make room for count more objects in the records and address index
+	void reserve_objects(size_t count) {
+		object_records_.reserve(object_records_.size() + count);
+		hierarchy_->objects.reserve(hierarchy_->objects.size() + count);
 	}
 
 	size_t num_object_records() const {
@@ -419,21 +634,217 @@ protected:
 	{
 		class_info* info;
 
+		bool is_virtual;
+
+		// Pointer adjustment from our type to the base's type,
+		// valid only for non-virtual bases
+		std::ptrdiff_t offset;
+
 		// This function takes a pointer to our type and transforms it to
 		// a pointer of the base's type
 		cast_function upcast;
 
-		managed_shared_ptr_ptr_cast_function managed_shared_ptr_ptr_upcast;
-
-		base_class_info(class_info* info, cast_function upcst,
-										managed_shared_ptr_ptr_cast_function spupcast)
+		base_class_info(class_info* info, bool is_virt, std::ptrdiff_t offs,
+										cast_function upcst)
 			: info(info)
+			, is_virtual(is_virt)
+			, offset(offs)
 			, upcast(upcst)
-			, managed_shared_ptr_ptr_upcast(spupcast)
 		{
 		}
 	};
 
+	// One virtual base on an upcast path: adjust the pointer by offset,
+	// then call the cast function
+	struct upcast_step
+	{
+		std::ptrdiff_t offset;
+		cast_function cast;
+	};
+
+	// A direct or indirect base with the whole upcast path to it.
+	// Paths through non-virtual bases only are a single constant offset.
+	struct flat_base_info
+	{
+		class_info const* info;
+		std::vector<upcast_step> steps;
+		std::ptrdiff_t offset;
+
+		void const* cast(void const* ptr) const
+		{
+			char const* p = static_cast<char const*>(ptr);
+			for (upcast_step const& step : steps)
+			{
+				p = static_cast<char const*>(step.cast(p + step.offset));
+			}
+			return p + offset;
+		}
+	};
+
+	void add_upcast(flat_base_info&& base)
+	{
+		auto it = std::find_if(upcasts_.begin(), upcasts_.end(),
+			[&base](flat_base_info const& other) { return other.info == base.info; });
+		if (it == upcasts_.end())
+		{
+			upcasts_.emplace_back(std::move(base));
+		}
+	}
+
+	// Rebuild the flattened table of this class and of all its derivatives.
+	// Direct bases go first, then the bases of bases, in the same order
+	// the hierarchy was searched before the table existed.
+	void update_upcasts()
+	{
+		upcasts_.clear();
+		for (base_class_info const& base : bases_)
+		{
+			flat_base_info direct{ base.info, {}, 0 };
+			if (base.is_virtual)
+			{
+				direct.steps.push_back(upcast_step{ 0, base.upcast });
+			}
+			else
+			{
+				direct.offset = base.offset;
+			}
+			add_upcast(std::move(direct));
+		}
+		for (size_t i = 0, count = bases_.size(); i < count; ++i)
+		{
+			flat_base_info const direct = upcasts_[i];
+			for (flat_base_info const& indirect : bases_[i].info->upcasts_)
+			{
+				flat_base_info base{ indirect.info, direct.steps, direct.offset };
+				for (upcast_step const& step : indirect.steps)
+				{
+					base.steps.push_back(upcast_step{ base.offset + step.offset, step.cast });
+					base.offset = 0;
+				}
+				base.offset += indirect.offset;
+				add_upcast(std::move(base));
+			}
+		}
+		for (derived_class_info const& deriv : derivatives_)
+		{
+			deriv.info->update_upcasts();
+		}
+	}
+
+	void count_wrap(size_t external_size)
+	{
+		++stats_.wraps;
+		stats_.peak = std::max(stats_.peak, live_objects());
+		stats_.external_bytes += static_cast<int64_t>(external_size);
+	}
+
+	size_t live_objects() const { return object_records_.size() + stats_.values; }
+
+	// Value objects are counted, but have no records
+	void add_value_object(size_t sz)
+	{
+		++stats_.values;
+		if (sz) {
+			external_memory_.adjust(static_cast<int64_t>(sz));
+		}
+		count_wrap(sz);
+	}
+
+	void remove_value_object(size_t sz)
+	{
+		assert(stats_.values > 0);
+		--stats_.values;
+		++stats_.removals;
+		if (sz) {
+			external_memory_.adjust(-static_cast<int64_t>(sz));
+			stats_.external_bytes -= static_cast<int64_t>(sz);
+		}
+	}
+
+	// Classes connected by inheritance share one index of the addresses
+	// of all their wrapped objects
+	struct hierarchy
+	{
+		std::vector<class_info*> classes;
+		ptr_map<class_info const*> objects;
+	};
+
+	// A class reachable from this one through bases and derivatives,
+	// with the casts leading to it
+	struct hierarchy_node
+	{
+		class_info const* info;
+		std::vector<cast_function> casts;
+
+		void const* cast(void const* ptr) const
+		{
+			for (cast_function cast : casts)
+			{
+				ptr = cast(ptr);
+			}
+			return ptr;
+		}
+	};
+
+	void merge_hierarchy(class_info* other)
+	{
+		std::shared_ptr<hierarchy> into = hierarchy_;
+		std::shared_ptr<hierarchy> from = other->hierarchy_;
+		if (into != from)
+		{
+			if (from->classes.size() > into->classes.size())
+			{
+				std::swap(into, from);
+			}
+			for (class_info* info : from->classes)
+			{
+				info->hierarchy_ = into;
+				into->classes.push_back(info);
+			}
+			from->objects.for_each([&into](void const* key, class_info const* owner)
+			{
+				into->objects.emplace(key, owner);
+			});
+		}
+		for (class_info* info : hierarchy_->classes)
+		{
+			info->update_closure();
+		}
+	}
+
+	// Depth-first search through the inheritance graph, bases first,
+	// done once on registration instead of on each wrap
+	void update_closure()
+	{
+		closure_.clear();
+		std::vector<cast_function> casts;
+		add_to_closure(this, casts);
+	}
+
+	void add_to_closure(class_info const* info, std::vector<cast_function>& casts)
+	{
+		for (hierarchy_node const& node : closure_)
+		{
+			if (node.info == info)
+			{
+				return;
+			}
+		}
+		closure_.push_back(hierarchy_node{ info, casts });
+		for (base_class_info const& base : info->bases_)
+		{
+			casts.push_back(base.upcast);
+			add_to_closure(base.info, casts);
+			casts.pop_back();
+		}
+		for (derived_class_info const& deriv : info->derivatives_)
+		{
+			casts.push_back(deriv.downcast);
+			add_to_closure(deriv.info, casts);
+			casts.pop_back();
+		}
+	}
+
 	struct derived_class_info
 	{
 		class_info* info;
@@ -449,11 +860,17 @@ protected:
 		}
 	};
 	
-	type_info const type_;
+	type_info const* type_;
+	external_memory& external_memory_;
+	// live is computed from object_records_ and values, name from type_
+	class_stats stats_;
 	std::vector<base_class_info> bases_;
 	std::vector<derived_class_info> derivatives_;
+	std::vector<flat_base_info> upcasts_;
+	std::shared_ptr<hierarchy> hierarchy_;
+	std::vector<hierarchy_node> closure_;
 
-	std::unordered_map<void const*, object_record> object_records_;
+	ptr_map<object_record> object_records_;
 	
 }; // end class_info
 
@@ -467,16 +884,19 @@ public:
 	static class_singleton<T>& add_class(v8::Isolate* isolate)
 	{
 		class_singletons* singletons = instance(add, isolate);
-		type_info const type = type_id<T>();
-		auto it = singletons->find(type);
-		if (it != singletons->classes_.end())
+		type_info const& type = type_id<T>();
+		if (singletons->find_info(type))
 		{
 			//assert(false && "class already registred");
 			throw std::runtime_error(class_name(type)
 				+ " is already exist in isolate " + pointer_str(isolate));
 		}
-		singletons->classes_.emplace_back(new class_singleton<T>(isolate, type));
-		return *static_cast<class_singleton<T>*>(singletons->classes_.back().get());
+		singletons->external_memory_.attach(isolate);
+		singletons->classes_.emplace_back(new class_singleton<T>(isolate, type,
+			singletons->external_memory_));
+		class_info* info = singletons->classes_.back().get();
+		singletons->set_slot(type, info);
+		return *static_cast<class_singleton<T>*>(info);
 	}
 
 	template<typename T>
@@ -485,14 +905,34 @@ public:
 		class_singletons* singletons = instance(get, isolate);
 		if (singletons)
 		{
-			type_info const type = type_id<T>();
+			type_info const& type = type_id<T>();
 			auto it = singletons->find(type);
 			if (it != singletons->classes_.end())
 			{
+				// queued objects may belong to the class
+				singletons->destruction_queue_.flush();
+				// the class may be cached under indices of other modules
+				for (class_info*& slot : singletons->slots_)
+				{
+					if (slot == it->get())
+					{
+						slot = nullptr;
+					}
+				}
 				singletons->classes_.erase(it);
+				++*singletons->generation_;
 				if (singletons->classes_.empty())
 				{
-					instance(remove, isolate);
+					if (singletons->external_memory_.threshold()
+						== external_memory::default_threshold)
+					{
+						instance(remove, isolate);
+					}
+					else
+					{
+						// keep the threshold set for the isolate until cleanup()
+						singletons->external_memory_.flush();
+					}
 				}
 			}
 		}
@@ -502,13 +942,12 @@ public:
 	static class_singleton<T>& find_class(v8::Isolate* isolate)
 	{
 		class_singletons* singletons = instance(get, isolate);
-		type_info const type = type_id<T>();
+		type_info const& type = type_id<T>();
 		if (singletons)
 		{
-			auto it = singletons->find(type);
-			if (it != singletons->classes_.end())
+			if (class_info* info = singletons->find_info(type))
 			{
-				return *static_cast<class_singleton<T>*>(it->get());
+				return *static_cast<class_singleton<T>*>(info);
 			}
 		}
 		//assert(false && "class not registered");
@@ -516,27 +955,209 @@ public:
 			+ " not found in isolate " + pointer_str(isolate));
 	}
 
+	// Registered class of the type, nullptr if not found
+	static class_info* find_class_info(v8::Isolate* isolate, type_info const& type)
+	{
+		class_singletons* singletons = instance(get, isolate);
+		return singletons? singletons->find_info(type) : nullptr;
+	}
+
+	// Counter of the isolate changed on removal of any class and of the
+	// isolate registry. A class pointer obtained while the counter was the
+	// same as now is still valid. The counter is shared by all modules
+	// and outlives the registry, so stale pointers are always detected.
+	static std::shared_ptr<size_t const> generation(v8::Isolate* isolate)
+	{
+		return instance(add, isolate)->generation_;
+	}
+
 	static void remove_all(v8::Isolate* isolate)
 	{
 		instance(remove, isolate);
 	}
 
+	// remove_all() for an isolate which is disposed next, without
+	// external memory reporting. Objects are destroyed class by class.
+	static teardown_stats teardown(v8::Isolate* isolate, unsigned max_threads)
+	{
+		using ms = std::chrono::duration<double, std::milli>;
+		auto const start = std::chrono::steady_clock::now();
+
+		teardown_stats result{};
+		if (class_singletons* singletons = instance(get, isolate))
+		{
+			singletons->destruction_queue_.flush();
+			// nothing to report to the isolate being disposed
+			singletons->external_memory_.attach(nullptr);
+			for (auto const& info : singletons->classes_)
+			{
+				info->teardown_objects(max_threads, result);
+				++result.classes;
+			}
+			instance(remove, isolate);
+		}
+		result.total_ms = ms(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	static std::vector<class_stats> get_stats(v8::Isolate* isolate)
+	{
+		std::vector<class_stats> result;
+		if (class_singletons* singletons = instance(get, isolate))
+		{
+			result.reserve(singletons->classes_.size());
+			for (auto const& info : singletons->classes_)
+			{
+				result.push_back(info->stats());
+			}
+		}
+		return result;
+	}
+
+	static void reset_stats(v8::Isolate* isolate)
+	{
+		if (class_singletons* singletons = instance(get, isolate))
+		{
+			for (auto const& info : singletons->classes_)
+			{
+				info->reset_stats();
+			}
+		}
+	}
+
+	// Slab pool of the isolate for objects of the size
+	static slab_pool& get_pool(v8::Isolate* isolate, size_t size)
+	{
+		class_singletons* singletons = instance(add, isolate);
+		size_t const block_size = slab_pool::size_class(size);
+		for (auto const& pool : singletons->pools_)
+		{
+			if (pool->block_size() == block_size)
+			{
+				return *pool;
+			}
+		}
+		singletons->pools_.emplace_back(new slab_pool(block_size));
+		return *singletons->pools_.back();
+	}
+
+	// External memory counter of the isolate, nullptr if there are
+	// no classes registered in it
+	static external_memory* find_external_memory(v8::Isolate* isolate)
+	{
+		class_singletons* singletons = instance(get, isolate);
+		return singletons? &singletons->external_memory_ : nullptr;
+	}
+
+	static external_memory& get_external_memory(v8::Isolate* isolate)
+	{
+		class_singletons* singletons = instance(add, isolate);
+		singletons->external_memory_.attach(isolate);
+		return singletons->external_memory_;
+	}
+
+	// Queue of collected objects waiting for destruction in the isolate
+	static destruction_queue& get_destruction_queue(v8::Isolate* isolate)
+	{
+		return instance(add, isolate)->destruction_queue_;
+	}
+
+	static destruction_queue* find_destruction_queue(v8::Isolate* isolate)
+	{
+		class_singletons* singletons = instance(get, isolate);
+		return singletons? &singletons->destruction_queue_ : nullptr;
+	}
+
+	class_singletons()
+		: generation_(std::make_shared<size_t>(0))
+	{
+	}
+
+	~class_singletons()
+	{
+		// destroy queued objects while their classes and pools are alive
+		destruction_queue_.flush();
+		++*generation_;
+	}
+
 private:
+	// Destroy the classes and report removal of their objects to the
+	// isolate, which is still alive. The registry destructor doesn't
+	// call V8, as the static registry may outlive the isolate.
+	void remove_classes()
+	{
+		destruction_queue_.flush();
+		classes_.clear();
+		external_memory_.flush();
+		external_memory_.attach(nullptr);
+	}
+
 	using classes = std::vector<std::unique_ptr<class_info>>;
+	external_memory external_memory_;
+	// pools of each size class, destroyed after the classes release
+	// their pooled objects
+	std::vector<std::unique_ptr<slab_pool>> pools_;
+	destruction_queue destruction_queue_;
+	std::shared_ptr<size_t> generation_;
 	classes classes_;
 
+	// Dense table indexed by type_info::index(), one load per lookup.
+	// A slot may be empty or hold another type when the same index was
+	// handed out in a different module, so find_info() falls back to
+	// the linear search in that case.
+	std::vector<class_info*> slots_;
+
 	classes::iterator find(type_info const& type)
 	{
 		return std::find_if(classes_.begin(), classes_.end(),
 			[&type](std::unique_ptr<class_info> const& info) { return info->type() == type; });
 	}
 
+	class_info* find_info(type_info const& type)
+	{
+		size_t const index = type.index();
+		class_info* info = index < slots_.size()? slots_[index] : nullptr;
+		if (info && &info->type() == &type)
+		{
+			// type_id<T>() of the module the class is registered from
+			return info;
+		}
+		if (info && info->type() == type)
+		{
+			// type_info of another module cached in its slot before
+			return info;
+		}
+		auto it = find(type);
+		if (it == classes_.end())
+		{
+			return nullptr;
+		}
+		if (index < slots_.size() && !slots_[index])
+		{
+			slots_[index] = it->get();
+		}
+		return it->get();
+	}
+
+	void set_slot(type_info const& type, class_info* info)
+	{
+		size_t const index = type.index();
+		if (index >= slots_.size())
+		{
+			slots_.resize(index + 1, nullptr);
+		}
+		slots_[index] = info;
+	}
+
 	enum operation { get, add, remove };
 	static class_singletons* instance(operation op, v8::Isolate* isolate)
 	{
 #if defined(V8PP_ISOLATE_DATA_SLOT)
+		// the slot is shared with the names of the isolate
+		isolate_data* data = op == add? &isolate_data::add(isolate)
+			: isolate_data::get(isolate);
 		class_singletons* instances =
-			static_cast<class_singletons*>(isolate->GetData(V8PP_ISOLATE_DATA_SLOT));
+			data? static_cast<class_singletons*>(data->classes) : nullptr;
 		switch (op)
 		{
 		case get:
@@ -545,14 +1166,16 @@ private:
 			if (!instances)
 			{
 				instances = new class_singletons;
-				isolate->SetData(V8PP_ISOLATE_DATA_SLOT, instances);
+				data->classes = instances;
 			}
 			return instances;
 		case remove:
 			if (instances)
 			{
+				instances->remove_classes();
 				delete instances;
-				isolate->SetData(V8PP_ISOLATE_DATA_SLOT, nullptr);
+				data->classes = nullptr;
+				isolate_data::release(isolate);
 			}
 		default:
 			return nullptr;
@@ -569,7 +1192,14 @@ private:
 		case add:
 			return &instances[isolate];
 		case remove:
-			instances.erase(isolate);
+			{
+				auto it = instances.find(isolate);
+				if (it != instances.end())
+				{
+					it->second.remove_classes();
+					instances.erase(it);
+				}
+			}
 		default:
 			return nullptr;
 		}
@@ -589,12 +1219,19 @@ template<typename T>
 class class_singleton : public class_info
 {
 public:
-	class_singleton(v8::Isolate* isolate, type_info const& type)
-		: class_info(type)
+	class_singleton(v8::Isolate* isolate, type_info const& type,
+		external_memory& memory)
+		: class_info(type, memory)
 		, isolate_(isolate)
 		, ctor_(nullptr)
 		, shared_ctor_(nullptr)
 		, dtor_(&default_delete_func<T>)
+		, pool_(nullptr)
+		, ctor_pooled_(false)
+		, destruction_queue_(nullptr)
+		, thread_safe_destroy_(false)
+		, value_wrapping_(false)
+		, inline_storage_(false)
 		, object_size_func_(&default_object_size_func<T>)
 		, count_shared_as_externally_allocated_(false)
 		, throw_exception_when_object_not_found_(true)
@@ -619,10 +1256,22 @@ public:
 		func_.Reset(isolate_, func);
 		js_func_.Reset(isolate_, js_func);
 
-		// each JavaScript instance has 2 internal fields:
+		// each JavaScript instance has 3 internal fields:
 		//  0 - pointer to a wrapped C++ object
 		//  1 - pointer to the class_singleton
-		func->InstanceTemplate()->SetInternalFieldCount(2);
+		//  2 - object_flags
+		func->InstanceTemplate()->SetInternalFieldCount(internal_field_count);
+	}
+
+	// Class of the isolate, throws if it is not registered or removed
+	static class_singleton& find(v8::Isolate* isolate)
+	{
+		return class_singletons::find_class<T>(isolate);
+	}
+
+	static std::shared_ptr<size_t const> generation(v8::Isolate* isolate)
+	{
+		return class_singletons::generation(isolate);
 	}
 
 	class_singleton(class_singleton const&) = delete;
@@ -641,7 +1290,8 @@ public:
 	v8::Handle<v8::Object> wrap(T* object,
 															bool can_modify,
 															bool claim_ownership,
-															bool count_against_vm_size)
+															bool count_against_vm_size,
+															bool pooled = false)
 	{
 
 		if (object_already_wrapped(object)) {
@@ -652,32 +1302,9 @@ public:
 		v8::EscapableHandleScope scope(isolate_);
 		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
 
-		v8::Local<v8::Object> obj =
-			class_function_template()->GetFunction()->NewInstance(context).
-			ToLocalChecked();
-		obj->SetAlignedPointerInInternalField(0, object);
-		obj->SetAlignedPointerInInternalField(1, this);
-
-		persistent<v8::Object> pobj(isolate_, obj);
-
-		pobj.SetWeak
-			(object,
-			 [](v8::WeakCallbackInfo<T> const& data)
-			 {
-				 v8::Isolate* isolate = data.GetIsolate();
-				 T* object = data.GetParameter();
-				 auto& csing = class_singletons::find_class<T>(isolate);
-				 csing.remove_object(object);
-			 }
-			 , v8::WeakCallbackType::kParameter
-			 );
-		
-		class_info::add_object(isolate_, object, std::move(pobj),
-													 can_modify,
-													 claim_ownership,
-													 count_against_vm_size,
-													 object_size_func_);
-
+		v8::Local<v8::Object> obj = new_instance
+			(class_function(context), context, object,
+			 can_modify, claim_ownership, count_against_vm_size, pooled);
 		return scope.Escape(obj);
 	}
 
@@ -695,35 +1322,63 @@ public:
 		v8::EscapableHandleScope scope(isolate_);
 		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
 
-		v8::Local<v8::Object> obj = class_function_template()->GetFunction()->
-			NewInstance(context).ToLocalChecked();
-		obj->SetAlignedPointerInInternalField(0, object.get());
-		obj->SetAlignedPointerInInternalField(1, this);
+		v8::Local<v8::Object> obj = new_shared_instance
+			(class_function(context), context, std::move(object),
+			 can_modify, count_against_vm_size);
+		return scope.Escape(obj);
+	}
 
-		persistent<v8::Object> pobj(isolate_, obj);
+	// Wrap a range of T* into a new JavaScript array. All the pointers
+	// are checked before any of them is wrapped, so on exception nothing
+	// has been wrapped.
+	template<typename Iterator>
+	v8::Handle<v8::Array> wrap_range(Iterator first, Iterator last,
+																	 bool can_modify,
+																	 bool claim_ownership,
+																	 bool count_against_vm_size)
+	{
+		size_t const count = check_range(first, last,
+			[](T* object) -> T const* { return object; });
 
-		auto callback =
-			[](v8::WeakCallbackInfo<T> const& data)
-			{
-				v8::Isolate* isolate = data.GetIsolate();
-				T* object = data.GetParameter();
-				auto& csing = class_singletons::find_class<T>(isolate);
-				csing.remove_object(object);
-			};
-		
-		pobj.SetWeak
-			(object.get(), callback
-			 , v8::WeakCallbackType::kParameter
-			 );
-			 
-		class_info::add_shared_object(isolate_, object, std::move(pobj),
-																	can_modify,
-																	count_against_vm_size,
-																	object_size_func_);
-		return scope.Escape(obj);
+		v8::EscapableHandleScope scope(isolate_);
+		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+		v8::Local<v8::Function> func = class_function(context);
+		v8::Local<v8::Array> result = v8::Array::New(isolate_, static_cast<int>(count));
+
+		reserve_objects(count);
+		uint32_t index = 0;
+		for (; first != last; ++first, ++index)
+		{
+			result->Set(context, index, new_instance(func, context, *first,
+				can_modify, claim_ownership, count_against_vm_size, false)).FromJust();
+		}
+		return scope.Escape(result);
 	}
-	
-	
+
+	// Wrap a range of shared_ptr<T> into a new JavaScript array
+	template<typename Iterator>
+	v8::Handle<v8::Array> wrap_shared_range(Iterator first, Iterator last,
+																					bool can_modify,
+																					bool count_against_vm_size)
+	{
+		size_t const count = check_range(first, last,
+			[](std::shared_ptr<T> const& object) -> T const* { return object.get(); });
+
+		v8::EscapableHandleScope scope(isolate_);
+		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+		v8::Local<v8::Function> func = class_function(context);
+		v8::Local<v8::Array> result = v8::Array::New(isolate_, static_cast<int>(count));
+
+		reserve_objects(count);
+		uint32_t index = 0;
+		for (; first != last; ++first, ++index)
+		{
+			result->Set(context, index, new_shared_instance(func, context, *first,
+				can_modify, count_against_vm_size)).FromJust();
+		}
+		return scope.Escape(result);
+	}
+
 	v8::Isolate* isolate() { return isolate_; }
 
 	v8::Local<v8::FunctionTemplate> class_function_template()
@@ -736,12 +1391,53 @@ public:
 		return to_local(isolate_, js_func_.IsEmpty()? func_ : js_func_);
 	}
 
+	// Class function instantiated in the context. It is cached, so that
+	// V8 does not search the instantiated template for each new object.
+	// Both cached handles are weak: the cache doesn't keep the context
+	// alive, and entries of collected contexts are dropped on a miss.
+	v8::Local<v8::Function> class_function(v8::Local<v8::Context> context)
+	{
+		for (context_function const& cached : functions_)
+		{
+			if (cached.context == context && !cached.function.IsEmpty())
+			{
+				return to_local(isolate_, cached.function);
+			}
+		}
+
+		functions_.erase(std::remove_if(functions_.begin(), functions_.end(),
+			[&context](context_function const& cached)
+			{
+				return cached.context.IsEmpty() || cached.context == context;
+			}), functions_.end());
+
+		v8::Local<v8::Function> func =
+			class_function_template()->GetFunction(context).ToLocalChecked();
+		functions_.emplace_back(isolate_, context, func);
+		return func;
+	}
+
+	// Number of contexts with a cached class function
+	size_t cached_function_count() const { return functions_.size(); }
+
 	// Uses T constructor with given type signature 
 	template <typename ...Args>
 	void use_class_constructor() {
 		assert(ctor_ == nullptr);
 		assert(shared_ctor_ == nullptr);		
-		auto fn = get_function_for_constructor<T, Args...>();
+		if (inline_storage_)
+		{
+			auto fn = get_function_for_value_constructor<T, Args...>();
+			inline_ctor_ = [fn](v8::FunctionCallbackInfo<v8::Value> const& args)
+			{
+				return call_from_v8(fn, args);
+			};
+			class_function_template()->Inherit(js_function_template());
+			return;
+		}
+		ctor_pooled_ = pool_ != nullptr;
+		auto fn = pool_? get_function_for_pooled_constructor<T, Args...>(*pool_)
+			: get_function_for_constructor<T, Args...>();
 		ctor_ = [fn](v8::FunctionCallbackInfo<v8::Value> const& args)
 		{
 			return call_from_v8(fn, args);
@@ -789,9 +1485,71 @@ public:
 	}
 
 	void set_destroy_func(const std::function<void(T*)>& f) {
+		if (pool_) {
+			throw std::runtime_error(class_name(type())
+				+ " destroy function can't be used with the pool allocator");
+		}
 		dtor_ = f;
 	}
 
+	// Allocate objects created by use_class_constructor() from the
+	// isolate slab pool of sizeof(T) blocks
+	void use_pool_allocator(slab_pool& pool) {
+		static_assert(alignof(T) <= slab_pool::alignment,
+			"over-aligned classes can't use the pool allocator");
+		if (ctor_ || shared_ctor_) {
+			throw std::runtime_error(class_name(type())
+				+ " pool allocator must be set before the constructor");
+		}
+		if (has_destroy_func()) {
+			throw std::runtime_error(class_name(type())
+				+ " pool allocator can't be used with a destroy function");
+		}
+		assert(pool.block_size() == slab_pool::size_class(sizeof(T)));
+		pool_ = &pool;
+	}
+
+	bool uses_pool_allocator() const { return pool_ != nullptr; }
+
+	// Objects collected by GC are unlinked in the weak callback and
+	// destroyed later from the queue, on its background thread if
+	// the destroy function and the destructor are thread-safe
+	void use_deferred_destruction(destruction_queue& queue) {
+		destruction_queue_ = &queue;
+	}
+
+	bool uses_deferred_destruction() const { return destruction_queue_ != nullptr; }
+
+	// The destroy function and the destructor may run on other threads
+	void set_thread_safe_destroy(bool thread_safe) {
+		thread_safe_destroy_ = thread_safe;
+	}
+
+	// Wrap objects returned by value without registering them
+	void use_value_wrapping(bool value_wrapping) {
+		value_wrapping_ = value_wrapping;
+	}
+
+	bool uses_value_wrapping() const { return value_wrapping_; }
+
+	// Keep objects created by the class constructor and returned by
+	// value in an ArrayBuffer of the wrapper, without a registry record
+	void use_inline_storage() {
+		static_assert(std::is_trivially_copyable<T>::value,
+			"only trivially copyable classes can use inline storage");
+		static_assert(alignof(T) <= slab_pool::alignment,
+			"over-aligned classes can't use inline storage");
+		if (ctor_ || shared_ctor_ || inline_ctor_) {
+			throw std::runtime_error(class_name(type())
+				+ " inline storage must be set before the constructor");
+		}
+		inline_storage_ = true;
+		class_function_template()->InstanceTemplate()->
+			SetInternalFieldCount(inline_internal_field_count);
+	}
+
+	bool uses_inline_storage() const { return inline_storage_; }
+
 	const std::function<void(T*)>& get_destroy_func() const { return dtor_; }
 	
 	void set_object_size_func(const std::function<size_t(const T*)>& f) {
@@ -831,9 +1589,15 @@ public:
 	
 	template<typename U>
 	void inherit()
+	{
+		inherit<U>(is_virtual_base_of<U, T>());
+	}
+
+	template<typename U>
+	void inherit(std::false_type /*virtual_base*/)
 	{
 		class_singleton<U>* base = &class_singletons::find_class<U>(isolate_);
-		add_base(base,
+		add_base(base, false, base_offset<U>(),
 			[](void const* ptr) -> void const*
 			{
 				return static_cast<U const*>(static_cast<T const*>(ptr));
@@ -841,21 +1605,21 @@ public:
 			[](void const* ptr) -> void const*
 			{
 			  return static_cast<T const*>(static_cast<U const*>(ptr));
-  	  },
-			[](const managed_shared_ptr_ptr& p) -> managed_shared_ptr_ptr
-			{
-				std::shared_ptr<T>* tp = static_cast<std::shared_ptr<T>*>(p.get());
-				std::shared_ptr<U>* up = new std::shared_ptr<U>(*tp);
-				return managed_shared_ptr_ptr(up);
-			});
+  	  });
 		js_function_template()->Inherit(base->class_function_template());
 	}
 
+	template<typename U>
+	void inherit(std::true_type /*virtual_base*/)
+	{
+		virtually_inherit<U>();
+	}
+
 	template<typename U>
 	void virtually_inherit()
 	{
 		class_singleton<U>* base = &class_singletons::find_class<U>(isolate_);
-		add_base(base,
+		add_base(base, true, 0,
 			[](void const* ptr) -> void const*
 			{
 				return static_cast<U const*>(static_cast<T const*>(ptr));
@@ -863,13 +1627,7 @@ public:
 			[](void const* ptr) -> void const*
 			{
 			  return dynamic_cast<T const*>(static_cast<U const*>(ptr));
-  	  },
-			[](const managed_shared_ptr_ptr& p) -> managed_shared_ptr_ptr
-			{
-				std::shared_ptr<T>* tp = static_cast<std::shared_ptr<T>*>(p.get());
-				std::shared_ptr<U>* up = new std::shared_ptr<U>(*tp);
-				return managed_shared_ptr_ptr(up);
-			});
+  	  });
 		js_function_template()->Inherit(base->class_function_template());
 	}
 	
@@ -889,12 +1647,75 @@ public:
 	{
 		return wrap(const_cast<T*>(object), false, true, true);
 	}
+
+	// Wrap a copy of the value owned by the wrapper. With value wrapping
+	// the copy shares one allocation with its weak handle and has no
+	// record, so find_object() doesn't see it.
+	v8::Handle<v8::Object> wrap_value(T value, bool can_modify)
+	{
+		if (inline_storage_)
+		{
+			return wrap_inline(value, can_modify);
+		}
+		if (!value_wrapping_)
+		{
+			return wrap(new T(std::move(value)), can_modify, true, true);
+		}
+
+		v8::EscapableHandleScope scope(isolate_);
+		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+		v8::Local<v8::Object> obj = class_function(context)->NewInstance(context).ToLocalChecked();
+
+		value_holder* holder = new value_holder(std::move(value));
+		obj->SetAlignedPointerInInternalField(object_field, &holder->value);
+		obj->SetAlignedPointerInInternalField(class_field, this);
+		set_object_flags(obj, make_object_flags(can_modify, true, false, true));
+
+		holder->handle.Reset(isolate_, obj);
+		holder->handle.SetWeak
+			(holder,
+			 [](v8::WeakCallbackInfo<value_holder> const& data)
+			 {
+				 auto& csing = class_singletons::find_class<T>(data.GetIsolate());
+				 csing.remove_collected_value(data.GetParameter());
+			 }
+			 , v8::WeakCallbackType::kParameter
+			 );
+		holder->external_size = object_size_func_? object_size_func_(&holder->value) : 0;
+		link_value(holder);
+		class_info::add_value_object(holder->external_size);
+		return scope.Escape(obj);
+	}
+
+	// Copy the value into an ArrayBuffer referenced by the wrapper.
+	// V8 frees the buffer with the wrapper, so there is neither
+	// a record nor a weak callback, and the object is not counted live.
+	v8::Handle<v8::Object> wrap_inline(T const& value, bool can_modify)
+	{
+		assert(inline_storage_);
+		v8::EscapableHandleScope scope(isolate_);
+		v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+		v8::Local<v8::Object> obj = class_function(context)->NewInstance(context).ToLocalChecked();
+
+		v8::Local<v8::ArrayBuffer> storage = v8::ArrayBuffer::New(isolate_, sizeof(T));
+		void* data = storage->GetContents().Data();
+		std::memcpy(data, &value, sizeof(T));
+		obj->SetAlignedPointerInInternalField(object_field, data);
+		obj->SetAlignedPointerInInternalField(class_field, this);
+		set_object_flags(obj, make_object_flags(can_modify, false, false, true)
+			| object_inline);
+		obj->SetInternalField(storage_field, storage);
+		class_info::count_wrap(0);
+		return scope.Escape(obj);
+	}
 	
 	v8::Handle<v8::Object> wrap_object(v8::FunctionCallbackInfo<v8::Value> const& args)
 	{
 
-		if (ctor_) {
-			return wrap_object(ctor_(args));
+		if (inline_ctor_) {
+			return wrap_inline(inline_ctor_(args), true);
+		} else if (ctor_) {
+			return wrap(ctor_(args), true, true, true, ctor_pooled_);
 		} else if (shared_ctor_) {
 			return wrap_shared(shared_ctor_(args), true,
 												 count_shared_as_externally_allocated_);
@@ -903,139 +1724,120 @@ public:
 		}
 	}
 
-  T const* unwrap_const_object(v8::Local<v8::Value> value)
+	T const* unwrap_const_object(v8::Local<v8::Value> value)
 	{
-		v8::HandleScope scope(isolate_);
-
-		while (value->IsObject())
+		T const* result = nullptr;
+		find_wrapper(value, [this, &result](v8::Local<v8::Object> obj)
 		{
-			v8::Handle<v8::Object> obj = value.As<v8::Object>();
-			if (obj->InternalFieldCount() == 2)
+			void* ptr = obj->GetAlignedPointerFromInternalField(object_field);
+			if (ptr == nullptr) {
+				throw std::runtime_error
+					(class_name(type()) + ": C++ object already removed");
+			}
+			class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(class_field));
+			assert((get_object_flags(obj) & object_value) ||
+						 info->find_object_record(ptr) != nullptr); // added by SD
+			if (info && info->upcast(ptr, type()))
 			{
-				void* ptr = obj->GetAlignedPointerFromInternalField(0);
-				if (ptr == nullptr) {
-					throw std::runtime_error
-						(class_name(type()) + ": C++ object already removed");
-				}
-				class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(1));
-				assert(info->find_object_record(ptr) != nullptr); // added by SD
-				if (info && info->upcast(ptr, type()))
-				{
-					return static_cast<T const*>(ptr);
-				}
+				result = static_cast<T const*>(ptr);
+				return true;
 			}
-			value = obj->GetPrototype();
-		}
-		return nullptr;
+			return false;
+		});
+		return result;
 	}
 	
 	T* unwrap_object(v8::Local<v8::Value> value)
 	{
-		v8::HandleScope scope(isolate_);
-
-		while (value->IsObject())
+		T* result = nullptr;
+		find_wrapper(value, [this, &result](v8::Local<v8::Object> obj)
 		{
-			v8::Handle<v8::Object> obj = value.As<v8::Object>();
-			if (obj->InternalFieldCount() == 2)
+			void* ptr = obj->GetAlignedPointerFromInternalField(object_field);
+			if (ptr == nullptr) {
+				throw std::runtime_error
+					(class_name(type()) + ": C++ object already removed");
+			}
+			
+			class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(class_field));
+			// access flags are kept in the wrapper, no record lookup here
+			uintptr_t const flags = get_object_flags(obj);
+			assert((flags & object_value) ||
+						 info->find_object_record(ptr) != nullptr);
+			assert((flags & object_value) ||
+						 info->find_object_record(ptr)->can_modify ==
+						 ((flags & object_can_modify) != 0));
+			if (info && info->upcast(ptr, type()))
 			{
-				void* ptr = obj->GetAlignedPointerFromInternalField(0);
-				if (ptr == nullptr) {
+				if (!(flags & object_can_modify)) {
 					throw std::runtime_error
-						(class_name(type()) + ": C++ object already removed");
-				}
-				
-				class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(1));
-				const object_record* orec = info->find_object_record(ptr);
-				assert(orec != nullptr);
-				if (info && info->upcast(ptr, type()))
-				{
-					if (orec->can_modify) {
-						return static_cast<T*>(ptr);
-					} else {
-						throw std::runtime_error
-							("Attempt to unwrap const C++ object (" + type().name() +
-							 ") for non-const access");
-						return nullptr;
-					}
+						("Attempt to unwrap const C++ object (" + type().name() +
+						 ") for non-const access");
 				}
+				result = static_cast<T*>(ptr);
+				return true;
 			}
-			value = obj->GetPrototype();
-		}
-		return nullptr;
+			return false;
+		});
+		return result;
 	}
 
 	std::shared_ptr<T> unwrap_shared_object(v8::Local<v8::Value> value)
 	{
-		v8::HandleScope scope(isolate_);
-		while (value->IsObject())
+		std::shared_ptr<T> result;
+		find_wrapper(value, [this, &result](v8::Local<v8::Object> obj)
 		{
-			v8::Handle<v8::Object> obj = value.As<v8::Object>();
-			if (obj->InternalFieldCount() == 2)
+			void* ptr = obj->GetAlignedPointerFromInternalField(object_field);
+			class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(class_field));
+			if (info)
 			{
-				void* ptr = obj->GetAlignedPointerFromInternalField(0);
-				class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(1));
-				if (info)
-				{
-					const object_record* orec = info->find_object_record(ptr);
-					assert(orec != nullptr);
-					if (!orec->shptr)
-					{
-						throw std::runtime_error
-							("Attempt to unwrap shared_ptr<" +
-							 info->type().name() + "> for non-shared object");
-					}
-					if (!orec->can_modify)
-					{
-						throw std::runtime_error
-							("Attempt to unwrap const C++ object (" + type().name() +
-							 ") for non-const access");
-						return nullptr;
-					}
-					managed_shared_ptr_ptr cast_mspp = info->managed_shared_ptr_ptr_upcast
-							(orec->shptr, type());
-					if (cast_mspp != nullptr)
-					{
-						return *(static_cast<std::shared_ptr<T>*>(cast_mspp.get()));
-					}
+				uintptr_t const flags = get_object_flags(obj);
+				if (!(flags & object_shared))
+				{
+					throw std::runtime_error
+						("Attempt to unwrap shared_ptr<" +
+						 info->type().name() + "> for non-shared object");
+				}
+				if (!(flags & object_can_modify))
+				{
+					throw std::runtime_error
+						("Attempt to unwrap const C++ object (" + type().name() +
+						 ") for non-const access");
 				}
+				// the record is needed only to get the shared_ptr itself
+				const object_record* orec = info->find_object_record(ptr);
+				assert(orec != nullptr && orec->shptr);
+				result = info->shared_ptr_upcast<T>(ptr, orec->shptr, type());
+				return result != nullptr;
 			}
-			value = obj->GetPrototype();
-		}
-		return nullptr;
+			return false;
+		});
+		return result;
 	}
 
 	std::shared_ptr<T const> unwrap_const_shared_object
 	(v8::Local<v8::Value> value)
 	{
-		v8::HandleScope scope(isolate_);
-		while (value->IsObject())
+		std::shared_ptr<T const> result;
+		find_wrapper(value, [this, &result](v8::Local<v8::Object> obj)
 		{
-			v8::Handle<v8::Object> obj = value.As<v8::Object>();
-			if (obj->InternalFieldCount() == 2)
+			void* ptr = obj->GetAlignedPointerFromInternalField(object_field);
+			class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(class_field));
+			if (info)
 			{
-				void* ptr = obj->GetAlignedPointerFromInternalField(0);
-				class_info* info = static_cast<class_info*>(obj->GetAlignedPointerFromInternalField(1));
-				if (info)
+				if (!(get_object_flags(obj) & object_shared))
 				{
-					const object_record* orec = info->find_object_record(ptr);
-					assert(orec != nullptr);
-					if (!orec->shptr)
-					{
-						throw std::runtime_error
-							("Attempt to unwrap shared_ptr<" +
-							 info->type().name() + "> for non-shared object");
-					}
-					managed_shared_ptr_ptr cast_mspp = info->managed_shared_ptr_ptr_upcast
-							(orec->shptr, type());
-					if (cast_mspp != nullptr)
-					{
-						return *(static_cast<std::shared_ptr<T>*>(cast_mspp.get()));
-					}
+					throw std::runtime_error
+						("Attempt to unwrap shared_ptr<" +
+						 info->type().name() + "> for non-shared object");
 				}
+				const object_record* orec = info->find_object_record(ptr);
+				assert(orec != nullptr && orec->shptr);
+				result = info->shared_ptr_upcast<T>(ptr, orec->shptr, type());
+				return result != nullptr;
 			}
-			value = obj->GetPrototype();
-		}
-		return nullptr;
+			return false;
+		});
+		return result;
 	}	
 	
 	v8::Handle<v8::Object> find_object_or_empty(T const* obj) const
@@ -1107,21 +1909,388 @@ public:
 	}
 	*/
 
-	void remove_object(T* obj)
+	// false if the object is not wrapped
+	bool remove_object(T* obj)
 	{
-		class_info::remove_object(isolate_, obj, dtor_, object_size_func_);
+		// value objects are not in the registry
+		if (value_holder** holder = values_.find(obj))
+		{
+			remove_value(*holder);
+			return true;
+		}
+		return class_info::remove_object(isolate_, obj,
+			[this](T* object, bool pooled) { destroy_object(object, pooled); });
 	}
 	
 	void remove_objects()
 	{
-		class_info::remove_objects(isolate_, dtor_, object_size_func_);
+		for (value_holder* holder : take_values())
+		{
+			holder->handle.Reset();
+			class_info::remove_value_object(holder->external_size);
+			delete holder;
+		}
+		class_info::remove_objects<T>(
+			[this](T* object, bool pooled) { destroy_object(object, pooled); });
+	}
+
+	void teardown_objects(unsigned max_threads, teardown_stats& stats) override
+	{
+		using ms = std::chrono::duration<double, std::milli>;
+		auto const start = std::chrono::steady_clock::now();
+
+		std::vector<value_holder*> values = take_values();
+		for (value_holder* holder : values)
+		{
+			holder->handle.Reset();
+			class_info::remove_value_object(0);
+		}
+		std::vector<std::pair<T*, bool>> objects;
+		class_info::release_objects(objects);
+
+		auto const unlinked = std::chrono::steady_clock::now();
+
+		for (value_holder* holder : values)
+		{
+			delete holder;
+		}
+		size_t const threads = destroy_objects(objects, max_threads);
+
+		auto const finish = std::chrono::steady_clock::now();
+		stats.objects += values.size() + objects.size();
+		stats.threads = std::max(stats.threads, threads);
+		stats.unlink_ms += ms(unlinked - start).count();
+		stats.destroy_ms += ms(finish - unlinked).count();
+	}
+
+	// Remove the object collected by GC, destroy it now or queue
+	void remove_collected_object(T* obj)
+	{
+		if (!destruction_queue_)
+		{
+			bool const removed = remove_object(obj);
+			assert(removed && "no object"); (void)removed;
+			return;
+		}
+		// the record owns the shared pointer, keep it for the queue
+		managed_shared_ptr_ptr shared = find_managed_shared_ptr_ptr(obj);
+		bool const background = thread_safe_destroy_;
+		bool const removed = class_info::remove_object(isolate_, obj,
+			[this, background](T* object, bool pooled)
+			{
+				// the slab pool is used on the isolate thread only
+				destruction_queue_->push(&destroy_queued_object, this, object, pooled,
+					nullptr, background && !pooled);
+			});
+		assert(removed && "no object"); (void)removed;
+		if (shared)
+		{
+			destruction_queue_->push(nullptr, this, obj, false,
+				std::move(shared), background);
+		}
 	}
 
 private:
+	// Call unwrap(obj) for the value and then for its prototypes, which
+	// have our internal fields, until it returns true. The value itself
+	// is checked first without any HandleScope: it is the wrapper in
+	// almost all calls, including instances of JavaScript classes that
+	// extend a wrapped class. Walking the prototype chain creates
+	// handles and needs a scope, so it is the fallback.
+	template<typename F>
+	void find_wrapper(v8::Local<v8::Value> value, F&& unwrap)
+	{
+		if (!value->IsObject())
+		{
+			return;
+		}
+		v8::Local<v8::Object> obj = value.As<v8::Object>();
+		if (is_wrapper(obj) && unwrap(obj))
+		{
+			++stats_.unwraps;
+			return;
+		}
+
+		v8::HandleScope scope(isolate_);
+		for (value = obj->GetPrototype(); value->IsObject(); value = obj->GetPrototype())
+		{
+			obj = value.As<v8::Object>();
+			if (is_wrapper(obj) && unwrap(obj))
+			{
+				++stats_.unwraps;
+				return;
+			}
+		}
+	}
+
+	// Destroy the objects, in parallel for thread-safe classes. The slab
+	// pool is not thread-safe, pooled objects are destroyed on this thread.
+	// Return the number of threads used.
+	size_t destroy_objects(std::vector<std::pair<T*, bool>> const& objects,
+		unsigned max_threads)
+	{
+		size_t const min_objects_per_thread = 4096;
+		size_t threads = 1;
+		if (thread_safe_destroy_ && !pool_)
+		{
+			threads = std::min<size_t>(max_threads, objects.size() / min_objects_per_thread);
+			threads = std::max<size_t>(threads, 1);
+		}
+
+		size_t const chunk = (objects.size() + threads - 1) / threads;
+		auto destroy_chunk = [this, &objects, chunk](size_t index)
+		{
+			size_t const end = std::min(objects.size(), (index + 1) * chunk);
+			for (size_t i = index * chunk; i < end; ++i)
+			{
+				destroy_object(objects[i].first, objects[i].second);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		for (size_t index = 1; index < threads; ++index)
+		{
+			workers.emplace_back(destroy_chunk, index);
+		}
+		destroy_chunk(0);
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		return threads;
+	}
+
+	static void destroy_queued_object(void* self, void* object, bool pooled)
+	{
+		static_cast<class_singleton*>(self)->destroy_object(static_cast<T*>(object), pooled);
+	}
+
+	// Value object with its weak handle, indexed by the value address
+	// to be found by remove_object() and destroyed with the class
+	struct value_holder
+	{
+		T value;
+		persistent<v8::Object> handle;
+		size_t external_size;
+
+		explicit value_holder(T&& v)
+			: value(std::move(v))
+			, external_size(0)
+		{
+		}
+	};
+
+	void link_value(value_holder* holder)
+	{
+		values_.emplace(&holder->value, holder);
+	}
+
+	void unlink_value(value_holder* holder)
+	{
+		values_.erase(&holder->value);
+	}
+
+	// Unlink all value objects, to be destroyed by the caller
+	std::vector<value_holder*> take_values()
+	{
+		std::vector<value_holder*> values;
+		values.reserve(values_.size());
+		values_.for_each([&values](void const*, value_holder* holder)
+		{
+			values.push_back(holder);
+		});
+		values_.clear();
+		return values;
+	}
+
+	// Destroy the value object, its wrapper can't be unwrapped after it
+	void remove_value(value_holder* holder)
+	{
+		if (!holder->handle.IsNearDeath())
+		{
+			v8::HandleScope scope(isolate_);
+			to_local(isolate_, holder->handle)->
+				SetAlignedPointerInInternalField(object_field, nullptr);
+		}
+		holder->handle.Reset();
+		unlink_value(holder);
+		class_info::remove_value_object(holder->external_size);
+		delete holder;
+	}
+
+	void remove_collected_value(value_holder* holder)
+	{
+		holder->handle.Reset();
+		unlink_value(holder);
+		class_info::remove_value_object(holder->external_size);
+		if (destruction_queue_)
+		{
+			destruction_queue_->push(&destroy_queued_value, this, holder, false,
+				nullptr, thread_safe_destroy_);
+		}
+		else
+		{
+			delete holder;
+		}
+	}
+
+	static void destroy_queued_value(void*, void* holder, bool)
+	{
+		delete static_cast<value_holder*>(holder);
+	}
+
+	// set_destroy_func() was called, pooled objects would bypass it
+	bool has_destroy_func() const
+	{
+		using delete_func = void (*)(T*);
+		delete_func const* f = dtor_.template target<delete_func>();
+		return !f || *f != &default_delete_func<T>;
+	}
+
+	// Objects created in the pool by the class constructor go back to
+	// the pool, other objects owned by wrappers go to the destroy function
+	void destroy_object(T* object, bool pooled)
+	{
+		if (pooled)
+		{
+			assert(pool_);
+			object->~T();
+			pool_->deallocate(object);
+		}
+		else if (dtor_)
+		{
+			dtor_(object);
+		}
+	}
+
+	// Create a JavaScript object for the C++ one and register it,
+	// the caller has checked the object is not wrapped yet
+	v8::Local<v8::Object> new_instance(v8::Local<v8::Function> func,
+																		 v8::Local<v8::Context> context,
+																		 T* object,
+																		 bool can_modify,
+																		 bool claim_ownership,
+																		 bool count_against_vm_size,
+																		 bool pooled)
+	{
+		v8::Local<v8::Object> obj = func->NewInstance(context).ToLocalChecked();
+		obj->SetAlignedPointerInInternalField(object_field, object);
+		obj->SetAlignedPointerInInternalField(class_field, this);
+		set_object_flags(obj, make_object_flags(can_modify, claim_ownership, false));
+
+		persistent<v8::Object> pobj(isolate_, obj);
+
+		pobj.SetWeak
+			(object,
+			 [](v8::WeakCallbackInfo<T> const& data)
+			 {
+				 v8::Isolate* isolate = data.GetIsolate();
+				 T* object = data.GetParameter();
+				 auto& csing = class_singletons::find_class<T>(isolate);
+				 csing.remove_collected_object(object);
+			 }
+			 , v8::WeakCallbackType::kParameter
+			 );
+		
+		// a pooled object holds the whole pool block
+		size_t const sz = !count_against_vm_size? 0
+			: pooled? pool_->block_size()
+			: object_size_func_? object_size_func_(object) : 0;
+		class_info::add_object(object, std::move(pobj),
+													 can_modify,
+													 claim_ownership,
+													 sz,
+													 pooled);
+		return obj;
+	}
+
+	v8::Local<v8::Object> new_shared_instance(v8::Local<v8::Function> func,
+																						v8::Local<v8::Context> context,
+																						std::shared_ptr<T> object,
+																						bool can_modify,
+																						bool count_against_vm_size)
+	{
+		v8::Local<v8::Object> obj = func->NewInstance(context).ToLocalChecked();
+		obj->SetAlignedPointerInInternalField(object_field, object.get());
+		obj->SetAlignedPointerInInternalField(class_field, this);
+		set_object_flags(obj, make_object_flags(can_modify, false, true));
+
+		persistent<v8::Object> pobj(isolate_, obj);
+
+		auto callback =
+			[](v8::WeakCallbackInfo<T> const& data)
+			{
+				v8::Isolate* isolate = data.GetIsolate();
+				T* object = data.GetParameter();
+				auto& csing = class_singletons::find_class<T>(isolate);
+				csing.remove_collected_object(object);
+			};
+		
+		pobj.SetWeak
+			(object.get(), callback
+			 , v8::WeakCallbackType::kParameter
+			 );
+			 
+		size_t const sz = count_against_vm_size && object_size_func_?
+			object_size_func_(object.get()) : 0;
+		class_info::add_shared_object(object, std::move(pobj),
+																	can_modify,
+																	sz);
+		return obj;
+	}
+
+	// Throw if any object in the range is already wrapped or occurs
+	// in the range twice, return the range length
+	template<typename Iterator, typename GetPointer>
+	size_t check_range(Iterator first, Iterator last, GetPointer get_pointer) const
+	{
+		ptr_map<bool> seen;
+		seen.reserve(static_cast<size_t>(std::distance(first, last)));
+		for (; first != last; ++first)
+		{
+			T const* object = get_pointer(*first);
+			if (!seen.emplace(object, true).second || object_already_wrapped(object))
+			{
+				throw std::runtime_error
+					(type().name() + " (or super/subclass) already wrapped: " +
+					 pointer_str(object));
+			}
+		}
+		return seen.size();
+	}
+	// Constant pointer adjustment from T to its non-virtual base U.
+	// The cast of a non-null aligned address is not dereferenced, it only
+	// does address arithmetic. A virtual base offset is stored in the
+	// object, so it is not constant.
+	template<typename U>
+	static std::ptrdiff_t base_offset()
+	{
+		static_assert(!is_virtual_base_of<U, T>::value,
+			"U is a virtual base of T, it has no constant offset");
+		T const* derived = reinterpret_cast<T const*>(alignof(T));
+		U const* base = static_cast<U const*>(derived);
+		return reinterpret_cast<char const*>(base)
+			- reinterpret_cast<char const*>(derived);
+	}
+
 	v8::Isolate* isolate_;
 	std::function<T* (v8::FunctionCallbackInfo<v8::Value> const& args)> ctor_;
 	std::function<std::shared_ptr<T> (v8::FunctionCallbackInfo<v8::Value> const& args)> shared_ctor_;
 	std::function<void(T*)> dtor_;
+	slab_pool* pool_;
+	// ctor_ allocates objects from pool_
+	bool ctor_pooled_;
+	// queue for objects collected by GC, nullptr to destroy them at once
+	destruction_queue* destruction_queue_;
+	// destroy functions may run on the queue and teardown threads
+	bool thread_safe_destroy_;
+	bool value_wrapping_;
+	// value objects alive, by the value address
+	ptr_map<value_holder*> values_;
+	// objects are stored in the wrappers, constructed by inline_ctor_
+	bool inline_storage_;
+	std::function<T (v8::FunctionCallbackInfo<v8::Value> const& args)> inline_ctor_;
 	typedef std::function<size_t(const T*)> object_size_func_type;
 	object_size_func_type object_size_func_;
 	bool count_shared_as_externally_allocated_;
@@ -1130,6 +2299,22 @@ private:
 	
 	v8::UniquePersistent<v8::FunctionTemplate> func_;
 	v8::UniquePersistent<v8::FunctionTemplate> js_func_;
+
+	struct context_function
+	{
+		persistent<v8::Context> context;
+		persistent<v8::Function> function;
+
+		context_function(v8::Isolate* isolate, v8::Local<v8::Context> ctx,
+			v8::Local<v8::Function> func)
+			: context(isolate, ctx)
+			, function(isolate, func)
+		{
+			context.SetWeak();
+			function.SetWeak();
+		}
+	};
+	std::vector<context_function> functions_;
 };
 
 } // namespace detail
@@ -1148,6 +2333,68 @@ public:
 	{
 	}
 
+	/// Allocate objects created by the class constructor from a slab
+	/// pool shared by classes of the same size in the isolate, instead
+	/// of new and delete. Must be called before use_class_constructor().
+	/// Pooled objects are destroyed in the pool, so a class with the pool
+	/// allocator can't have a destroy function, and vice versa.
+	class_& use_pool_allocator()
+	{
+		class_singleton_.use_pool_allocator(detail::class_singletons::get_pool(
+			class_singleton_.isolate(), sizeof(T)));
+		return *this;
+	}
+
+	/// Destroy objects collected by GC outside of the GC pause: weak
+	/// callbacks only unlink them and the objects wait in the isolate
+	/// queue for drain_destruction_queue(). If thread_safe is set, the
+	/// destroy function and the destructor of T may run on a background
+	/// thread, and the objects are destroyed there without a drain.
+	class_& use_deferred_destruction(bool thread_safe = false)
+	{
+		if (thread_safe)
+		{
+			class_singleton_.set_thread_safe_destroy(true);
+		}
+		class_singleton_.use_deferred_destruction(
+			detail::class_singletons::get_destruction_queue(class_singleton_.isolate()));
+		return *this;
+	}
+
+	/// Wrap objects of the class returned by value from C++ functions
+	/// without the registry: the JavaScript object owns the copy, which
+	/// shares one allocation with its weak handle. Suits value types
+	/// with no identity. find_object() doesn't see such objects,
+	/// remove_object() destroys them and detaches from the wrapper.
+	class_& use_value_wrapping(bool value_wrapping = true)
+	{
+		class_singleton_.use_value_wrapping(value_wrapping);
+		return *this;
+	}
+
+	/// Store objects of a small trivially copyable class in the wrapper:
+	/// objects created by the class constructor and returned by value
+	/// live in an ArrayBuffer held by the JavaScript object, without
+	/// a registry record or a weak callback. The buffer is still a second
+	/// JavaScript object with a backing store allocated by V8, so this
+	/// saves the record and the weak handle work, not the allocation.
+	/// Must be called before use_class_constructor(). Such objects are
+	/// not counted live, find_object() doesn't see them and
+	/// try_remove_object() returns false for them.
+	class_& use_inline_storage()
+	{
+		class_singleton_.use_inline_storage();
+		return *this;
+	}
+
+	/// Allow the destroy function and the destructor of T to run on
+	/// other threads: objects are destroyed in parallel on teardown()
+	class_& set_thread_safe_destroy(bool thread_safe)
+	{
+		class_singleton_.set_thread_safe_destroy(thread_safe);
+		return *this;
+	}
+
 	template<typename ...Args>
 	class_& use_class_constructor()
 	{
@@ -1200,7 +2447,8 @@ public:
 		return *this;
 	}
 	
-	/// Inhert from C++ class U
+	/// Inhert from C++ class U, a virtual base U is bound as with
+	/// virtually_inherit<U>()
 	template<typename U>
 	class_& inherit()
 	{
@@ -1226,7 +2474,8 @@ public:
 	set(char const *name, Method mem_func)
 	{
 		class_singleton_.class_function_template()->PrototypeTemplate()->Set(
-			isolate(), name, wrap_function_template(isolate(), mem_func));
+			v8pp::name(isolate(), name), detail::wrap_method_template(isolate(),
+				class_singleton_, mem_func));
 		return *this;
 	}
 
@@ -1235,7 +2484,7 @@ public:
 	typename std::enable_if<detail::is_callable<Fun>::value, class_&>::type
 	set(char const *name, Function&& func)
 	{
-		class_singleton_.js_function_template()->Set(isolate(), name,
+		class_singleton_.js_function_template()->Set(v8pp::name(isolate(), name),
 			wrap_function_template(isolate(), std::forward<Fun>(func)));
 		return *this;
 	}
@@ -1245,7 +2494,7 @@ public:
 	class_& set_object_member_function(char const *name, Function&& func)
 	{
 		class_singleton_.class_function_template()->PrototypeTemplate()->Set(
-			isolate(), name, wrap_function_template_called_as_method
+			v8pp::name(isolate(), name), wrap_function_template_called_as_method
 			(isolate(), std::forward<Fun>(func)));
 		return *this;
 	}
@@ -1258,7 +2507,7 @@ public:
 						 int>::type=0>
 	class_& set_static_class_function(char const* name, Function&& func)
 	{
-		class_singleton_.js_function_template()->Set(isolate(), name,
+		class_singleton_.js_function_template()->Set(v8pp::name(isolate(), name),
 			wrap_function_template_called_as_nonmethod
 			(isolate(), std::forward<Fun>(func)));
 		return *this;
@@ -1283,7 +2532,7 @@ public:
 		v8::PropertyAttribute const prop_attrs = v8::PropertyAttribute(v8::DontDelete | (setter? 0 : v8::ReadOnly));
 
 		class_singleton_.class_function_template()->PrototypeTemplate()->SetAccessor(
-			v8pp::to_v8(isolate(), name), getter, setter, data, v8::DEFAULT, prop_attrs);
+			v8pp::name(isolate(), name), getter, setter, data, v8::DEFAULT, prop_attrs);
 		return *this;
 	}
 
@@ -1306,7 +2555,7 @@ public:
 		v8::Handle<v8::Value> data = detail::set_external_data(isolate(), std::forward<prop_type>(prop));
 		v8::PropertyAttribute const prop_attrs = v8::PropertyAttribute(v8::DontDelete | (setter? 0 : v8::ReadOnly));
 
-		class_singleton_.class_function_template()->PrototypeTemplate()->SetAccessor(v8pp::to_v8(isolate(), name),
+		class_singleton_.class_function_template()->PrototypeTemplate()->SetAccessor(v8pp::name(isolate(), name),
 			getter, setter, data, v8::DEFAULT, prop_attrs);
 		return *this;
 	}
@@ -1317,7 +2566,7 @@ public:
 	{
 		v8::HandleScope scope(isolate());
 
-		class_singleton_.class_function_template()->PrototypeTemplate()->Set(v8pp::to_v8(isolate(), name),
+		class_singleton_.class_function_template()->PrototypeTemplate()->Set(v8pp::name(isolate(), name),
 			to_v8(isolate(), value), v8::PropertyAttribute(v8::ReadOnly | v8::DontDelete));
 		return *this;
 	}
@@ -1352,7 +2601,15 @@ public:
 	
 	static void remove_object(v8::Isolate* isolate, T* obj)
 	{
-		detail::class_singletons::find_class<T>(isolate).remove_object(obj);
+		bool const removed = detail::class_singletons::find_class<T>(isolate).remove_object(obj);
+		assert(removed && "no object"); (void)removed;
+	}
+
+	/// As remove_object(), return false if the object is not wrapped,
+	/// including objects kept in their wrappers by use_inline_storage()
+	static bool try_remove_object(v8::Isolate* isolate, T* obj)
+	{
+		return detail::class_singletons::find_class<T>(isolate).remove_object(obj);
 	}
 	
 	/// As reference_external but delete memory for C++ object
@@ -1368,7 +2625,41 @@ public:
 		return detail::class_singletons::find_class<T>(isolate).wrap_const_object
 			(ext);		
 	}
+
+	/// Create JavaScript object which owns a copy of the value,
+	/// see use_value_wrapping()
+	static v8::Handle<v8::Object> import_value(v8::Isolate* isolate, T value)
+	{
+		return detail::class_singletons::find_class<T>(isolate).
+			wrap_value(std::move(value), true);
+	}
+
+	static v8::Handle<v8::Object> import_const_value(v8::Isolate* isolate, T value)
+	{
+		return detail::class_singletons::find_class<T>(isolate).
+			wrap_value(std::move(value), false);
+	}
 	
+	/// Wrap a range of T* at once, as reference_external does for each,
+	/// and return them in a JavaScript array
+	template<typename Iterator>
+	static v8::Handle<v8::Array> reference_externals(v8::Isolate* isolate,
+																									 Iterator first, Iterator last)
+	{
+		return detail::class_singletons::find_class<T>(isolate).
+			wrap_range(first, last, true, false, false);
+	}
+
+	/// Wrap a range of T* at once, as import_external does for each,
+	/// and return them in a JavaScript array
+	template<typename Iterator>
+	static v8::Handle<v8::Array> import_externals(v8::Isolate* isolate,
+																								Iterator first, Iterator last)
+	{
+		return detail::class_singletons::find_class<T>(isolate).
+			wrap_range(first, last, true, true, true);
+	}
+
 	/// Get wrapped object from V8 value, may return nullptr on fail.
 	static T* unwrap_object(v8::Isolate* isolate, v8::Handle<v8::Value> value)
 	{
@@ -1413,6 +2704,17 @@ public:
 			(std::const_pointer_cast<T>(obj), false,
 			 c.get_count_shared_against_vm_size());
 	}
+
+	/// Wrap a range of shared_ptr<T> at once, as wrap_shared_object does
+	/// for each, and return them in a JavaScript array
+	template<typename Iterator>
+	static v8::Handle<v8::Array> wrap_shared_objects(v8::Isolate* isolate,
+																									 Iterator first, Iterator last)
+	{
+		auto& c = detail::class_singletons::find_class<T>(isolate);
+		return c.wrap_shared_range
+			(first, last, true, c.get_count_shared_against_vm_size());
+	}
 	
 	static bool object_already_wrapped(v8::Isolate* isolate, T const* obj) {
 		auto& c = detail::class_singletons::find_class<T>(isolate);
@@ -1507,6 +2809,12 @@ public:
 		detail::class_singletons::remove_class<T>(isolate);
 	}
 
+	/// Counters of wrapped objects of this class
+	static class_stats stats(v8::Isolate* isolate)
+	{
+		return detail::class_singletons::find_class<T>(isolate).stats();
+	}
+
 	static size_t num_objects(v8::Isolate* isolate) {
 		return detail::class_singletons::find_class<T>(isolate).
 			num_object_records();
@@ -1538,6 +2846,90 @@ private:
 inline void cleanup(v8::Isolate* isolate)
 {
 	detail::class_singletons::remove_all(isolate);
+	detail::external_string_memory::detach(isolate, true);
+	detail::external_buffers::release_all(isolate);
+	clear_names(isolate);
+}
+
+/// Faster cleanup() for an isolate which is disposed right after it,
+/// called explicitly before the disposal. External memory is not reported
+/// back and wrapper objects are not neutered, so only the objects are
+/// destroyed. Classes marked with set_thread_safe_destroy() use up to
+/// max_threads threads, 0 for the hardware concurrency. No script may
+/// use wrapped objects in the isolate after it.
+inline teardown_stats teardown(v8::Isolate* isolate, unsigned max_threads = 0)
+{
+	if (max_threads == 0)
+	{
+		max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	clear_names(isolate);
+	detail::external_string_memory::detach(isolate, false);
+	detail::external_buffers::release_all(isolate, false);
+	return detail::class_singletons::teardown(isolate, max_threads);
+}
+
+/// Get counters of all classes registered in the isolate
+inline std::vector<class_stats> get_class_stats(v8::Isolate* isolate)
+{
+	return detail::class_singletons::get_stats(isolate);
+}
+
+/// Reset wraps, unwraps and removals of all classes in the isolate
+inline void reset_class_stats(v8::Isolate* isolate)
+{
+	detail::class_singletons::reset_stats(isolate);
+}
+
+/// Get external memory counters of the isolate, all zero if
+/// no classes are registered in it
+inline external_memory_stats get_external_memory_stats(v8::Isolate* isolate)
+{
+	detail::external_memory const* memory =
+		detail::class_singletons::find_external_memory(isolate);
+	if (!memory)
+	{
+		return external_memory_stats{ 0, 0, 0 };
+	}
+	return external_memory_stats{ memory->reported(), memory->pending(),
+		memory->threshold() };
+}
+
+/// Set the amount of pending external memory which is reported to V8
+/// at once. 0 reports each wrapped object change immediately.
+/// The threshold is kept for classes registered later, until cleanup().
+inline void set_external_memory_threshold(v8::Isolate* isolate, int64_t threshold)
+{
+	detail::class_singletons::get_external_memory(isolate).set_threshold(threshold);
+}
+
+/// Report pending external memory of wrapped objects to V8 now
+inline void flush_external_memory(v8::Isolate* isolate)
+{
+	if (detail::external_memory* memory =
+		detail::class_singletons::find_external_memory(isolate))
+	{
+		memory->flush();
+	}
+}
+
+/// Destroy up to max_count objects of classes with deferred destruction
+/// collected by GC, all of them if max_count is 0. Call on the isolate
+/// thread at idle points. Return the number of destroyed objects.
+inline size_t drain_destruction_queue(v8::Isolate* isolate, size_t max_count = 0)
+{
+	detail::destruction_queue* queue =
+		detail::class_singletons::find_destruction_queue(isolate);
+	return queue? queue->drain(max_count) : 0;
+}
+
+/// Get counters of the deferred destruction queue, all zero if
+/// no classes are registered in the isolate
+inline destruction_queue_stats get_destruction_queue_stats(v8::Isolate* isolate)
+{
+	detail::destruction_queue const* queue =
+		detail::class_singletons::find_destruction_queue(isolate);
+	return queue? queue->stats() : destruction_queue_stats{};
 }
 
 } // namespace v8pp
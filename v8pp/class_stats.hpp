@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_CLASS_STATS_HPP_INCLUDED
+#define V8PP_CLASS_STATS_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace v8pp {
+
+/// Counters of wrapped objects of a class in an isolate
+struct class_stats
+{
+	std::string name;       // C++ class name
+	size_t live;            // currently wrapped objects
+	size_t peak;            // max live objects since reset
+	size_t shared;          // live objects held by shared_ptr
+	size_t owned;           // live objects deleted with their wrapper
+	size_t values;          // live value objects, not in the registry
+	size_t wraps;           // wrapped objects since reset
+	size_t unwraps;         // unwrapped values since reset
+	size_t removals;        // removed objects since reset
+	int64_t external_bytes; // live object sizes counted against the VM heap
+};
+
+/// Result of teardown() of an isolate
+struct teardown_stats
+{
+	size_t classes;   // removed classes
+	size_t objects;   // destroyed C++ objects
+	size_t threads;   // max threads used to destroy objects of a class
+	double unlink_ms; // dropping records and wrapper handles
+	double destroy_ms; // running destroy functions and destructors
+	double total_ms;
+};
+
+/// External memory of wrapped objects counted against the VM heap
+struct external_memory_stats
+{
+	int64_t reported;  // already reported to V8
+	int64_t pending;   // accumulated, not reported yet
+	int64_t threshold; // pending amount reported to V8 at once
+};
+
+} // namespace v8pp
+
+#endif // V8PP_CLASS_STATS_HPP_INCLUDED
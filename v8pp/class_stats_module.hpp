@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_CLASS_STATS_MODULE_HPP_INCLUDED
+#define V8PP_CLASS_STATS_MODULE_HPP_INCLUDED
+
+#include <v8.h>
+
+#include "v8pp/class.hpp"
+#include "v8pp/class_stats.hpp"
+#include "v8pp/module.hpp"
+#include "v8pp/object.hpp"
+
+namespace v8pp {
+
+/// Convert class counters into a JavaScript object
+inline v8::Local<v8::Object> class_stats_to_v8(v8::Isolate* isolate,
+	class_stats const& stats)
+{
+	v8::EscapableHandleScope scope(isolate);
+
+	v8::Local<v8::Object> obj = v8::Object::New(isolate);
+	set_option(isolate, obj, "live", stats.live);
+	set_option(isolate, obj, "peak", stats.peak);
+	set_option(isolate, obj, "shared", stats.shared);
+	set_option(isolate, obj, "owned", stats.owned);
+	set_option(isolate, obj, "values", stats.values);
+	set_option(isolate, obj, "wraps", stats.wraps);
+	set_option(isolate, obj, "unwraps", stats.unwraps);
+	set_option(isolate, obj, "removals", stats.removals);
+	set_option(isolate, obj, "externalBytes", stats.external_bytes);
+
+	return scope.Escape(obj);
+}
+
+namespace class_stats_module {
+
+/// classes() returns an object with counters of each registered class
+/// by its C++ name
+inline void classes(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	v8::Isolate* isolate = args.GetIsolate();
+	v8::EscapableHandleScope scope(isolate);
+
+	v8::Local<v8::Object> result = v8::Object::New(isolate);
+	for (class_stats const& stats : get_class_stats(isolate))
+	{
+		result->Set(to_v8(isolate, stats.name), class_stats_to_v8(isolate, stats));
+	}
+	args.GetReturnValue().Set(scope.Escape(result));
+}
+
+/// externalMemory() returns external memory counters of the isolate
+inline void external_memory(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	v8::Isolate* isolate = args.GetIsolate();
+	v8::EscapableHandleScope scope(isolate);
+
+	external_memory_stats const stats = get_external_memory_stats(isolate);
+	v8::Local<v8::Object> result = v8::Object::New(isolate);
+	set_option(isolate, result, "reported", stats.reported);
+	set_option(isolate, result, "pending", stats.pending);
+	set_option(isolate, result, "threshold", stats.threshold);
+	args.GetReturnValue().Set(scope.Escape(result));
+}
+
+/// destructionQueue() returns deferred destruction queue counters
+inline void destruction_queue(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	v8::Isolate* isolate = args.GetIsolate();
+	v8::EscapableHandleScope scope(isolate);
+
+	destruction_queue_stats const stats = get_destruction_queue_stats(isolate);
+	v8::Local<v8::Object> result = v8::Object::New(isolate);
+	set_option(isolate, result, "depth", stats.depth);
+	set_option(isolate, result, "backgroundDepth", stats.background_depth);
+	set_option(isolate, result, "peakDepth", stats.peak_depth);
+	set_option(isolate, result, "enqueued", stats.enqueued);
+	set_option(isolate, result, "destroyed", stats.destroyed);
+	set_option(isolate, result, "maxLatencyMs", stats.max_latency_ms);
+	set_option(isolate, result, "avgLatencyMs", stats.avg_latency_ms);
+	set_option(isolate, result, "lastDrainMs", stats.last_drain_ms);
+	args.GetReturnValue().Set(scope.Escape(result));
+}
+
+/// reset() resets event counters of all classes
+inline void reset(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	reset_class_stats(args.GetIsolate());
+}
+
+/// Create a module instance with classes(), externalMemory(),
+/// destructionQueue() and reset()
+inline v8::Handle<v8::Value> init(v8::Isolate* isolate)
+{
+	v8pp::module m(isolate);
+	m.set("classes", &classes);
+	m.set("externalMemory", &external_memory);
+	m.set("destructionQueue", &destruction_queue);
+	m.set("reset", &reset);
+	return m.new_instance();
+}
+
+} // namespace class_stats_module
+
+} // namespace v8pp
+
+#endif // V8PP_CLASS_STATS_MODULE_HPP_INCLUDED
@@ -28,6 +28,13 @@
 	#endif
 #endif
 
+/// Minimal length of std::string results returned by value from wrapped
+/// functions to be moved into an external V8 string instead of a copy,
+/// 0 (default) to disable. Applies to ASCII UTF-8 and to UTF-16 strings.
+#if !defined(V8PP_EXTERNAL_STRING_THRESHOLD)
+#define V8PP_EXTERNAL_STRING_THRESHOLD 0
+#endif
+
 #if defined(_MSC_VER)
 	#define V8PP_EXPORT __declspec(dllexport)
 	#define V8PP_IMPORT __declspec(dllimport)
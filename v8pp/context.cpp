@@ -195,8 +195,16 @@ context::context(v8::Isolate* isolate, v8::ArrayBuffer::Allocator* allocator)
 
 context::~context()
 {
-	// remove all class singletons before modules unload
-	cleanup(isolate_);
+	// remove all class singletons before modules unload,
+	// without reporting back to the isolate disposed below
+	if (own_isolate_)
+	{
+		teardown(isolate_);
+	}
+	else
+	{
+		cleanup(isolate_);
+	}
 
 	for (auto& kv : modules_)
 	{
@@ -227,7 +235,7 @@ context::~context()
 context& context::set(char const* name, v8::Handle<v8::Value> value)
 {
 	v8::HandleScope scope(isolate_);
-	to_local(isolate_, impl_)->Global()->Set(to_v8(isolate_, name), value);
+	to_local(isolate_, impl_)->Global()->Set(v8pp::name(isolate_, name), value);
 	return *this;
 }
 
@@ -15,6 +15,7 @@
 #include <v8.h>
 
 #include "v8pp/convert.hpp"
+#include "v8pp/name_cache.hpp"
 
 namespace v8pp {
 
@@ -62,7 +63,7 @@ public:
 	context& set(char const* name, class_<T>& cl)
 	{
 		v8::HandleScope scope(isolate_);
-		cl.class_function_template()->SetClassName(v8pp::to_v8(isolate_, name));
+		cl.class_function_template()->SetClassName(v8pp::name(isolate_, name));
 		return set(name, cl.js_function_template()->GetFunction());
 	}
 
@@ -13,11 +13,18 @@
 
 #include <v8.h>
 
+#include "v8pp/config.hpp"
+
 #include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <array>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <iterator>
 #include <stdexcept>
 #include <type_traits>
@@ -43,6 +50,172 @@ struct convert;
 };
 */
 
+/// Non-owning reference to UTF-8 characters. As a parameter of a wrapped
+/// function it refers to the argument converted without a heap
+/// allocation for short strings, valid only during the call.
+class string_view
+{
+public:
+	string_view() : data_(""), size_(0) {}
+	string_view(char const* data, size_t size) : data_(data), size_(size) {}
+	string_view(char const* str) : data_(str), size_(std::strlen(str)) {}
+	string_view(std::string const& str) : data_(str.data()), size_(str.size()) {}
+
+	char const* data() const { return data_; }
+	size_t size() const { return size_; }
+	size_t length() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	char const* begin() const { return data_; }
+	char const* end() const { return data_ + size_; }
+	char operator[](size_t pos) const { return data_[pos]; }
+
+	std::string str() const { return std::string(data_, size_); }
+
+	friend bool operator==(string_view a, string_view b)
+	{
+		return a.size_ == b.size_ && std::memcmp(a.data_, b.data_, a.size_) == 0;
+	}
+
+	friend bool operator!=(string_view a, string_view b) { return !(a == b); }
+
+private:
+	char const* data_;
+	size_t size_;
+};
+
+namespace detail {
+
+/// Copy of a V8 string for a string_view or a Char const* argument, written
+/// once into the inline buffer for short strings and into the heap
+/// otherwise. Characters are UTF-8 for 1-byte Char and UTF-16 for 2-byte
+/// one, always followed by a null terminator.
+template<typename Char>
+class basic_string_buffer
+{
+public:
+	enum { inline_capacity = 128 };
+
+	basic_string_buffer(v8::Isolate* isolate, v8::Local<v8::String> str)
+	{
+		// capacity without the terminator
+		int const length = str->Length();
+		int capacity = length;
+		if (sizeof(Char) == 1)
+		{
+			// one UTF-16 code unit takes at most 3 bytes in UTF-8,
+			// so a short string fits without measuring it,
+			// computed in size_t, Length() * 3 overflows int for long strings
+			capacity = static_cast<size_t>(length) * 3 < inline_capacity?
+				inline_capacity - 1 : str->Utf8Length(isolate);
+		}
+		if (capacity < inline_capacity)
+		{
+			data_ = inline_;
+		}
+		else
+		{
+			heap_.reset(new Char[capacity + 1]);
+			data_ = heap_.get();
+		}
+		if (sizeof(Char) == 1)
+		{
+			size_ = str->WriteUtf8(isolate, reinterpret_cast<char*>(data_), capacity,
+				nullptr, v8::String::NO_NULL_TERMINATION);
+		}
+		else
+		{
+			size_ = str->Write(isolate, reinterpret_cast<uint16_t*>(data_), 0, length,
+				v8::String::NO_NULL_TERMINATION);
+		}
+		data_[size_] = Char();
+	}
+
+	basic_string_buffer(basic_string_buffer&& src)
+		: heap_(std::move(src.heap_))
+		, size_(src.size_)
+	{
+		if (heap_)
+		{
+			data_ = heap_.get();
+		}
+		else
+		{
+			data_ = inline_;
+			std::memcpy(inline_, src.inline_, (size_ + 1) * sizeof(Char));
+		}
+		src.data_ = src.inline_;
+		src.size_ = 0;
+		src.inline_[0] = Char();
+	}
+
+	basic_string_buffer(basic_string_buffer const& src)
+		: size_(src.size_)
+	{
+		if (src.heap_)
+		{
+			heap_.reset(new Char[size_ + 1]);
+			data_ = heap_.get();
+		}
+		else
+		{
+			data_ = inline_;
+		}
+		std::memcpy(data_, src.data_, (size_ + 1) * sizeof(Char));
+	}
+
+	basic_string_buffer& operator=(basic_string_buffer const&) = delete;
+
+	Char const* c_str() const { return data_; }
+	Char const* data() const { return data_; }
+	size_t size() const { return size_; }
+	size_t length() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	std::basic_string<Char> str() const { return std::basic_string<Char>(data_, size_); }
+
+	operator Char const*() const { return data_; }
+	operator string_view() const { return string_view(data_, size_); }
+
+	friend bool operator==(basic_string_buffer const& a, std::basic_string<Char> const& b)
+	{
+		return a.size_ == b.size() && std::memcmp(a.data_, b.data(), a.size_ * sizeof(Char)) == 0;
+	}
+
+	friend bool operator==(basic_string_buffer const& a, Char const* b)
+	{
+		size_t i = 0;
+		for (; i < a.size_ && b[i] != Char(); ++i)
+		{
+			if (a.data_[i] != b[i])
+			{
+				return false;
+			}
+		}
+		return i == a.size_ && b[i] == Char();
+	}
+
+	friend bool operator!=(basic_string_buffer const& a, std::basic_string<Char> const& b)
+	{
+		return !(a == b);
+	}
+
+	friend bool operator!=(basic_string_buffer const& a, Char const* b)
+	{
+		return !(a == b);
+	}
+
+private:
+	Char inline_[inline_capacity];
+	std::unique_ptr<Char[]> heap_;
+	Char* data_;
+	size_t size_;
+};
+
+using string_buffer = basic_string_buffer<char>;
+
+} // namespace detail
+
 // converter specializations for string types
 template<typename Char, typename Traits, typename Alloc>
 struct convert<std::basic_string<Char, Traits, Alloc>>
@@ -53,6 +226,9 @@ struct convert<std::basic_string<Char, Traits, Alloc>>
 	using from_type = std::basic_string<Char, Traits, Alloc>;
 	using to_type = v8::Handle<v8::String>;
 
+	// UTF-8 size of strings written without measuring
+	enum { max_unmeasured_size = 1024 };
+
 	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
 	{
 		return !value.IsEmpty() && value->IsString();
@@ -65,16 +241,34 @@ struct convert<std::basic_string<Char, Traits, Alloc>>
 			throw std::invalid_argument("expected String");
 		}
 
+		// written right into the result
+		v8::Local<v8::String> const str = value.As<v8::String>();
+		int const length = str->Length();
+		from_type result;
+		if (length == 0)
+		{
+			return result;
+		}
 		if (sizeof(Char) == 1)
 		{
-			v8::String::Utf8Value const str(isolate, value);
-			return from_type(reinterpret_cast<Char const*>(*str), str.length());
+			// one UTF-16 code unit takes at most 3 bytes in UTF-8, so a short
+			// string is written in one pass without measuring it first.
+			// Long ones are measured, not to keep 3 times the capacity.
+			size_t const max_size = static_cast<size_t>(length) * 3;
+			int const capacity = max_size <= max_unmeasured_size?
+				static_cast<int>(max_size) : str->Utf8Length(isolate);
+			result.resize(capacity);
+			int const size = str->WriteUtf8(isolate, reinterpret_cast<char*>(&result[0]),
+				capacity, nullptr, v8::String::NO_NULL_TERMINATION);
+			result.resize(size);
 		}
 		else
 		{
-			v8::String::Value const str(isolate, value);
-			return from_type(reinterpret_cast<Char const*>(*str), str.length());
+			result.resize(length);
+			str->Write(isolate, reinterpret_cast<uint16_t*>(&result[0]),
+				0, length, v8::String::NO_NULL_TERMINATION);
 		}
+		return result;
 	}
 
 	static to_type to_v8(v8::Isolate* isolate, from_type const& value)
@@ -126,14 +320,8 @@ struct convert<Char const*,
 		"only UTF-8 and UTF-16 strings are supported");
 
 
-	// A string that converts to Char const *
-	struct convertible_string : std::basic_string<Char>
-	{
-		convertible_string(Char const* str, size_t len) : std::basic_string<Char>(str, len) {}
-		operator Char const*() const { return this->c_str(); }
-	};
-
-	using from_type = convertible_string;
+	// converts to Char const*, valid while the buffer is alive
+	using from_type = detail::basic_string_buffer<Char>;
 	using to_type = v8::Handle<v8::String>;
 
 	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
@@ -148,16 +336,7 @@ struct convert<Char const*,
 			throw std::invalid_argument("expected String");
 		}
 
-		if (sizeof(Char) == 1)
-		{
-			v8::String::Utf8Value const str(isolate, value);
-			return from_type(reinterpret_cast<Char const*>(*str), str.length());
-		}
-		else
-		{
-			v8::String::Value const str(isolate, value);
-			return from_type(reinterpret_cast<Char const*>(*str), str.length());
-		}
+		return from_type(isolate, value.As<v8::String>());
 	}
 
 	static to_type to_v8(v8::Isolate* isolate, Char const* value, size_t len = ~0)
@@ -175,6 +354,289 @@ struct convert<Char const*,
 	}
 };
 
+template<>
+struct convert<string_view>
+{
+	using from_type = detail::string_buffer;
+	using to_type = v8::Handle<v8::String>;
+
+	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
+	{
+		return !value.IsEmpty() && value->IsString();
+	}
+
+	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		if (!is_valid(isolate, value))
+		{
+			throw std::invalid_argument("expected String");
+		}
+		return from_type(isolate, value.As<v8::String>());
+	}
+
+	static to_type to_v8(v8::Isolate* isolate, string_view value)
+	{
+		return v8::String::NewFromUtf8(isolate, value.data(),
+			v8::String::kNormalString, static_cast<int>(value.size()));
+	}
+};
+
+/// String result handed to V8 without a copy. The characters are moved
+/// into an external string resource, reported to V8 as external memory
+/// and freed when the string is collected. UTF-8 content is external
+/// when it is ASCII and copied otherwise; latin1 content is always
+/// external, as is UTF-16 one for 2-byte Char.
+template<typename Char>
+class basic_external_string
+{
+	static_assert(sizeof(Char) <= sizeof(uint16_t),
+		"only UTF-8 and UTF-16 strings are supported");
+public:
+	enum encoding { utf8, latin1 };
+
+	explicit basic_external_string(std::basic_string<Char> str, encoding enc = utf8)
+		: str_(std::move(str))
+		, encoding_(enc)
+	{
+	}
+
+	std::basic_string<Char>& str() { return str_; }
+	std::basic_string<Char> const& str() const { return str_; }
+	encoding get_encoding() const { return encoding_; }
+
+private:
+	std::basic_string<Char> str_;
+	encoding encoding_;
+};
+
+using external_string = basic_external_string<char>;
+using external_u16string = basic_external_string<uint16_t>;
+
+namespace detail {
+
+/// External memory of the string resources alive in an isolate.
+///
+/// Resources share it with the isolate registry and report their sizes
+/// through it. V8 disposes resources of strings still alive during the
+/// isolate disposal, when the isolate can't be adjusted any more, so
+/// cleanup() and teardown() detach it from the isolate before.
+class external_string_memory
+{
+public:
+	explicit external_string_memory(v8::Isolate* isolate) : isolate_(isolate), bytes_(0) {}
+
+	external_string_memory(external_string_memory const&) = delete;
+	external_string_memory& operator=(external_string_memory const&) = delete;
+
+	static std::shared_ptr<external_string_memory> acquire(v8::Isolate* isolate)
+	{
+		return instance(add, isolate);
+	}
+
+	/// Memory of the isolate, nullptr if it has no external strings
+	/// or it is detached
+	static std::shared_ptr<external_string_memory> find(v8::Isolate* isolate)
+	{
+		return instance(get, isolate);
+	}
+
+	/// Stop reporting to the isolate, report the live strings as
+	/// released first unless the isolate is disposed without it
+	static void detach(v8::Isolate* isolate, bool report)
+	{
+		std::shared_ptr<external_string_memory> memory = instance(get, isolate);
+		if (memory)
+		{
+			if (report && memory->bytes_ != 0)
+			{
+				isolate->AdjustAmountOfExternalAllocatedMemory(-memory->bytes_);
+			}
+			memory->isolate_ = nullptr;
+			instance(remove, isolate);
+		}
+	}
+
+	v8::Isolate* isolate() const { return isolate_; }
+	int64_t bytes() const { return bytes_; }
+
+	// strings of an isolate are created and disposed on the isolate thread
+	void adjust(int64_t delta)
+	{
+		bytes_ += delta;
+		if (isolate_)
+		{
+			isolate_->AdjustAmountOfExternalAllocatedMemory(delta);
+		}
+	}
+
+private:
+	enum operation { get, add, remove };
+
+	static std::shared_ptr<external_string_memory> instance(operation op, v8::Isolate* isolate)
+	{
+		static std::unordered_map<v8::Isolate*, std::shared_ptr<external_string_memory>> instances;
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
+		switch (op)
+		{
+		case get:
+			{
+				auto it = instances.find(isolate);
+				return it != instances.end()? it->second : nullptr;
+			}
+		case add:
+			{
+				std::shared_ptr<external_string_memory>& memory = instances[isolate];
+				if (!memory)
+				{
+					memory = std::make_shared<external_string_memory>(isolate);
+				}
+				return memory;
+			}
+		case remove:
+			instances.erase(isolate);
+		default:
+			return nullptr;
+		}
+	}
+
+	v8::Isolate* isolate_;
+	int64_t bytes_;
+};
+
+/// External string resource owning a string. Resource is disposed by V8
+/// with the string, so the external memory adjustment is undone there,
+/// unless the memory was detached from the isolate being disposed.
+template<typename String, bool OneByte = sizeof(typename String::value_type) == 1>
+class external_string_resource : public std::conditional<OneByte,
+	v8::String::ExternalOneByteStringResource, v8::String::ExternalStringResource>::type
+{
+public:
+	using char_type = typename std::conditional<OneByte, char, uint16_t>::type;
+
+	external_string_resource(v8::Isolate* isolate, String str)
+		: memory_(external_string_memory::acquire(isolate))
+		, str_(std::move(str))
+	{
+		memory_->adjust(bytes());
+	}
+
+	~external_string_resource()
+	{
+		memory_->adjust(-bytes());
+	}
+
+	char_type const* data() const override
+	{
+		return reinterpret_cast<char_type const*>(str_.data());
+	}
+
+	size_t length() const override { return str_.size(); }
+
+private:
+	int64_t bytes() const
+	{
+		return static_cast<int64_t>(str_.size() * sizeof(typename String::value_type));
+	}
+
+	std::shared_ptr<external_string_memory> memory_;
+	String str_;
+};
+
+inline bool is_ascii(char const* str, size_t len)
+{
+	// no early exit, the loop is vectorized
+	unsigned char bits = 0;
+	for (size_t i = 0; i < len; ++i)
+	{
+		bits |= static_cast<unsigned char>(str[i]);
+	}
+	return bits < 0x80;
+}
+
+inline v8::MaybeLocal<v8::String> new_external(v8::Isolate* isolate,
+	v8::String::ExternalOneByteStringResource* resource)
+{
+	return v8::String::NewExternalOneByte(isolate, resource);
+}
+
+inline v8::MaybeLocal<v8::String> new_external(v8::Isolate* isolate,
+	v8::String::ExternalStringResource* resource)
+{
+	return v8::String::NewExternalTwoByte(isolate, resource);
+}
+
+inline v8::MaybeLocal<v8::String> new_copy(v8::Isolate* isolate,
+	char const* data, size_t length)
+{
+	return v8::String::NewFromOneByte(isolate, reinterpret_cast<uint8_t const*>(data),
+		v8::NewStringType::kNormal, static_cast<int>(length));
+}
+
+inline v8::MaybeLocal<v8::String> new_copy(v8::Isolate* isolate,
+	uint16_t const* data, size_t length)
+{
+	return v8::String::NewFromTwoByte(isolate, data,
+		v8::NewStringType::kNormal, static_cast<int>(length));
+}
+
+/// Move a string into a new external V8 string, an lvalue is copied.
+/// UTF-8 string which is not ASCII, or a string rejected by V8 as external,
+/// is copied to a regular one.
+template<typename String>
+v8::Local<v8::String> new_external_string(v8::Isolate* isolate, String&& str,
+	bool latin1 = false)
+{
+	using char_type = typename std::decay<String>::type::value_type;
+	static_assert(sizeof(char_type) <= sizeof(uint16_t),
+		"only UTF-8 and UTF-16 strings are supported");
+
+	if (sizeof(char_type) == 1 && !latin1
+		&& !is_ascii(reinterpret_cast<char const*>(str.data()), str.size()))
+	{
+		return v8::String::NewFromUtf8(isolate, reinterpret_cast<char const*>(str.data()),
+			v8::String::kNormalString, static_cast<int>(str.size()));
+	}
+
+	using resource = external_string_resource<typename std::decay<String>::type>;
+	resource* res = new resource(isolate, std::forward<String>(str));
+	v8::MaybeLocal<v8::String> result = new_external(isolate, res);
+	if (result.IsEmpty())
+	{
+		// V8 does not own the rejected resource
+		v8::MaybeLocal<v8::String> const copy = new_copy(isolate, res->data(), res->length());
+		delete res;
+		return copy.FromMaybe(v8::Local<v8::String>());
+	}
+	return result.ToLocalChecked();
+}
+
+} // namespace detail
+
+template<typename Char>
+struct convert<basic_external_string<Char>>
+{
+	using from_type = basic_external_string<Char>;
+	using to_type = v8::Handle<v8::String>;
+
+	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
+	{
+		return !value.IsEmpty() && value->IsString();
+	}
+
+	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		return from_type(isolate, value.As<v8::String>());
+	}
+
+	// copies the string once, a result returned by value is moved
+	static to_type to_v8(v8::Isolate* isolate, from_type const& value)
+	{
+		return detail::new_external_string(isolate, value.str(),
+			value.get_encoding() == from_type::latin1);
+	}
+};
+
 // converter specializations for primitive types
 template<>
 struct convert<bool>
@@ -315,7 +777,198 @@ struct convert<T, typename std::enable_if<std::is_floating_point<T>::value>::typ
 	}
 };
 
-// convert Array <-> std::array
+namespace detail {
+
+/// JavaScript typed array type for numbers of type T
+template<typename T>
+struct typed_array_traits
+{
+	static const bool is_supported = false;
+};
+
+#define V8PP_TYPED_ARRAY_TRAITS(T, ArrayType) \
+template<> \
+struct typed_array_traits<T> \
+{ \
+	static const bool is_supported = true; \
+	using array_type = v8::ArrayType; \
+	static bool is_array(v8::Local<v8::Value> value) { return value->Is##ArrayType(); } \
+	static char const* name() { return #ArrayType; } \
+}
+
+V8PP_TYPED_ARRAY_TRAITS(int8_t, Int8Array);
+V8PP_TYPED_ARRAY_TRAITS(uint8_t, Uint8Array);
+V8PP_TYPED_ARRAY_TRAITS(int16_t, Int16Array);
+V8PP_TYPED_ARRAY_TRAITS(uint16_t, Uint16Array);
+V8PP_TYPED_ARRAY_TRAITS(int32_t, Int32Array);
+V8PP_TYPED_ARRAY_TRAITS(uint32_t, Uint32Array);
+V8PP_TYPED_ARRAY_TRAITS(float, Float32Array);
+V8PP_TYPED_ARRAY_TRAITS(double, Float64Array);
+
+#undef V8PP_TYPED_ARRAY_TRAITS
+
+template<typename T>
+bool is_array_or_typed_array(v8::Handle<v8::Value> value)
+{
+	return !value.IsEmpty() && (value->IsArray()
+		|| (typed_array_traits<T>::is_supported && value->IsTypedArray()));
+}
+
+inline uint32_t array_length(v8::Local<v8::Value> value)
+{
+	return value->IsArray()? value.As<v8::Array>()->Length()
+		: static_cast<uint32_t>(value.As<v8::TypedArray>()->Length());
+}
+
+/// Container elements are converted in chunks of this size, each chunk
+/// in its own HandleScope. Handles of converted elements, including ones
+/// of nested containers, are released after each chunk, so a conversion
+/// never holds more than a chunk of them.
+enum { conversion_chunk_size = 256 };
+
+// Get a property of an object, throw if the access has thrown
+template<typename Key>
+v8::Local<v8::Value> get_property(v8::Local<v8::Context> context,
+	v8::Local<v8::Object> object, Key key)
+{
+	v8::Local<v8::Value> value;
+	if (!object->Get(context, key).ToLocal(&value))
+	{
+		throw std::runtime_error("can't get object property");
+	}
+	return value;
+}
+
+// Set a property of an object, throw if the access has thrown
+template<typename Key>
+void set_property(v8::Local<v8::Context> context,
+	v8::Local<v8::Object> object, Key key, v8::Local<v8::Value> value)
+{
+	if (!object->Set(context, key, value).FromMaybe(false))
+	{
+		throw std::runtime_error("can't set object property");
+	}
+}
+
+// Call f(index, element) for count elements of an array or an array-like
+// object, with indexed element access
+template<typename F>
+void get_elements(v8::Isolate* isolate, v8::Local<v8::Object> array, uint32_t count, F&& f)
+{
+	v8::Local<v8::Context> context = isolate->GetCurrentContext();
+	for (uint32_t i = 0; i < count; )
+	{
+		v8::HandleScope scope(isolate);
+		uint32_t const end = count - i > conversion_chunk_size?
+			i + conversion_chunk_size : count;
+		for (; i < end; ++i)
+		{
+			f(i, get_property(context, array, i));
+		}
+	}
+}
+
+// Set elements of [begin, end) converted with f(element) in array
+// from index 0, return the element count
+template<typename Iterator, typename F>
+uint32_t set_elements(v8::Isolate* isolate, v8::Local<v8::Object> array,
+	Iterator begin, Iterator end, F&& f)
+{
+	v8::Local<v8::Context> context = isolate->GetCurrentContext();
+	uint32_t i = 0;
+	while (begin != end)
+	{
+		v8::HandleScope scope(isolate);
+		for (uint32_t const chunk_end = i + conversion_chunk_size;
+			i < chunk_end && begin != end; ++i, ++begin)
+		{
+			set_property(context, array, i, f(*begin));
+		}
+	}
+	return i;
+}
+
+// Copy elements of a typed array of exactly T numbers with one memcpy,
+// return false for other values
+template<typename T>
+typename std::enable_if<typed_array_traits<T>::is_supported, bool>::type
+copy_typed_array(v8::Local<v8::Value> value, T* data, size_t size)
+{
+	if (!typed_array_traits<T>::is_array(value))
+	{
+		return false;
+	}
+	if (size)
+	{
+		value.As<v8::ArrayBufferView>()->CopyContents(data, size * sizeof(T));
+	}
+	return true;
+}
+
+template<typename T, typename Alloc>
+typename std::enable_if<typed_array_traits<T>::is_supported, bool>::type
+typed_array_to_vector(v8::Local<v8::Value> value, std::vector<T, Alloc>& result)
+{
+	if (!typed_array_traits<T>::is_array(value))
+	{
+		return false;
+	}
+	result.resize(value.As<v8::TypedArray>()->Length());
+	return copy_typed_array(value, result.data(), result.size());
+}
+
+template<typename T, typename Alloc>
+typename std::enable_if<!typed_array_traits<T>::is_supported, bool>::type
+typed_array_to_vector(v8::Local<v8::Value>, std::vector<T, Alloc>&)
+{
+	return false;
+}
+
+template<typename T, size_t N>
+typename std::enable_if<typed_array_traits<T>::is_supported, bool>::type
+typed_array_to_array(v8::Local<v8::Value> value, std::array<T, N>& result)
+{
+	return copy_typed_array(value, result.data(), N);
+}
+
+template<typename T, size_t N>
+typename std::enable_if<!typed_array_traits<T>::is_supported, bool>::type
+typed_array_to_array(v8::Local<v8::Value>, std::array<T, N>&)
+{
+	return false;
+}
+
+} // namespace detail
+
+/// Create a typed array of T numbers, copied with one memcpy
+template<typename T>
+v8::Local<typename detail::typed_array_traits<T>::array_type>
+	to_typed_array(v8::Isolate* isolate, T const* data, size_t size)
+{
+	size_t const bytes = size * sizeof(T);
+	v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, bytes);
+	if (bytes)
+	{
+		std::memcpy(buffer->GetContents().Data(), data, bytes);
+	}
+	return detail::typed_array_traits<T>::array_type::New(buffer, 0, size);
+}
+
+template<typename T, typename Alloc>
+v8::Local<typename detail::typed_array_traits<T>::array_type>
+	to_typed_array(v8::Isolate* isolate, std::vector<T, Alloc> const& value)
+{
+	return to_typed_array(isolate, value.data(), value.size());
+}
+
+template<typename T, size_t N>
+v8::Local<typename detail::typed_array_traits<T>::array_type>
+	to_typed_array(v8::Isolate* isolate, std::array<T, N> const& value)
+{
+	return to_typed_array(isolate, value.data(), N);
+}
+
+// convert Array <-> std::array, typed array of T is copied at once
 template<typename T, size_t N>
 struct convert<std::array<T, N>>
 {
@@ -324,7 +977,7 @@ struct convert<std::array<T, N>>
 
 	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
 	{
-		return !value.IsEmpty() && value->IsArray();
+		return detail::is_array_or_typed_array<T>(value);
 	}
 
 	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
@@ -335,19 +988,24 @@ struct convert<std::array<T, N>>
 		}
 
 		v8::HandleScope scope(isolate);
-		v8::Local<v8::Array> array = value.As<v8::Array>();
-
-		if (array->Length() != N)
+		uint32_t const length = detail::array_length(value);
+		if (length != N)
 		{
 			throw std::runtime_error("Invalid array length: expected " + std::to_string(N)
-				+ " actual " + std::to_string(array->Length()));
+				+ " actual " + std::to_string(length));
 		}
 
 		from_type result;
-		for (uint32_t i = 0; i < N; ++i)
+		if (detail::typed_array_to_array(value, result))
 		{
-			result[i] = convert<T>::from_v8(isolate, array->Get(i));
+			return result;
 		}
+
+		detail::get_elements(isolate, value.As<v8::Object>(), N,
+			[isolate, &result](uint32_t i, v8::Local<v8::Value> element)
+			{
+				result[i] = convert<T>::from_v8(isolate, element);
+			});
 		return result;
 	}
 
@@ -356,15 +1014,13 @@ struct convert<std::array<T, N>>
 		v8::EscapableHandleScope scope(isolate);
 
 		v8::Local<v8::Array> result = v8::Array::New(isolate, N);
-		for (uint32_t i = 0; i < N; ++i)
-		{
-			result->Set(i, convert<T>::to_v8(isolate, value[i]));
-		}
+		detail::set_elements(isolate, result, value.begin(), value.end(),
+			[isolate](T const& element) { return convert<T>::to_v8(isolate, element); });
 		return scope.Escape(result);
 	}
 };
 
-// convert Array <-> std::vector
+// convert Array <-> std::vector, typed array of T is copied at once
 template<typename T, typename Alloc>
 struct convert<std::vector<T, Alloc>>
 {
@@ -373,7 +1029,7 @@ struct convert<std::vector<T, Alloc>>
 
 	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
 	{
-		return !value.IsEmpty() && value->IsArray();
+		return detail::is_array_or_typed_array<T>(value);
 	}
 
 	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
@@ -384,14 +1040,20 @@ struct convert<std::vector<T, Alloc>>
 		}
 
 		v8::HandleScope scope(isolate);
-		v8::Local<v8::Array> array = value.As<v8::Array>();
 
 		from_type result;
-		result.reserve(array->Length());
-		for (uint32_t i = 0, count = array->Length(); i < count; ++i)
+		if (detail::typed_array_to_vector(value, result))
 		{
-			result.emplace_back(convert<T>::from_v8(isolate, array->Get(i)));
+			return result;
 		}
+
+		uint32_t const count = detail::array_length(value);
+		result.reserve(count);
+		detail::get_elements(isolate, value.As<v8::Object>(), count,
+			[isolate, &result](uint32_t, v8::Local<v8::Value> element)
+			{
+				result.emplace_back(convert<T>::from_v8(isolate, element));
+			});
 		return result;
 	}
 
@@ -399,16 +1061,104 @@ struct convert<std::vector<T, Alloc>>
 	{
 		v8::EscapableHandleScope scope(isolate);
 
-		uint32_t const size = static_cast<uint32_t>(value.size());
-		v8::Local<v8::Array> result = v8::Array::New(isolate, size);
-		for (uint32_t i = 0; i < size; ++i)
-		{
-			result->Set(i, convert<T>::to_v8(isolate, value[i]));
-		}
+		v8::Local<v8::Array> result = v8::Array::New(isolate,
+			static_cast<int>(value.size()));
+		detail::set_elements(isolate, result, value.begin(), value.end(),
+			[isolate](T const& element) { return convert<T>::to_v8(isolate, element); });
 		return scope.Escape(result);
 	}
 };
 
+/// Non-owning reference to numbers in a JavaScript typed array. As a
+/// parameter of a wrapped function it refers to the backing store of the
+/// argument with no copy, valid only during the call. array_view<T const>
+/// is read-only.
+template<typename T>
+class array_view
+{
+public:
+	using value_type = T;
+
+	array_view() : data_(nullptr), size_(0) {}
+	array_view(T* data, size_t size) : data_(data), size_(size) {}
+
+	T* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	T* begin() const { return data_; }
+	T* end() const { return data_ + size_; }
+	T& operator[](size_t pos) const { return data_[pos]; }
+
+private:
+	T* data_;
+	size_t size_;
+};
+
+/// Vector of numbers converted to a JavaScript typed array of the same
+/// element type with one memcpy: Float64Array for double, Float32Array
+/// for float, Int32Array for int32_t and so on. Use it as a function
+/// result or a property type to opt in, std::vector is an Array.
+template<typename T, typename Alloc = std::allocator<T>>
+class typed_array : public std::vector<T, Alloc>
+{
+	static_assert(detail::typed_array_traits<T>::is_supported,
+		"typed arrays are for 8, 16, 32 bit integers, float and double");
+	using base = std::vector<T, Alloc>;
+public:
+	using base::base;
+
+	typed_array() = default;
+	typed_array(base&& other) : base(std::move(other)) {}
+	typed_array(base const& other) : base(other) {}
+};
+
+template<typename T, typename Alloc>
+struct convert<typed_array<T, Alloc>>
+{
+	using from_type = typed_array<T, Alloc>;
+	using to_type = v8::Handle<typename detail::typed_array_traits<T>::array_type>;
+
+	static bool is_valid(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		return convert<std::vector<T, Alloc>>::is_valid(isolate, value);
+	}
+
+	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		return convert<std::vector<T, Alloc>>::from_v8(isolate, value);
+	}
+
+	static to_type to_v8(v8::Isolate* isolate, from_type const& value)
+	{
+		return to_typed_array(isolate, value);
+	}
+};
+
+namespace detail {
+
+template<typename Key>
+v8::Local<v8::Value> property_key(v8::Isolate* isolate, Key const& key)
+{
+	return convert<Key>::to_v8(isolate, key);
+}
+
+// string keys are created internalized, V8 would internalize them on Set()
+template<typename Traits, typename Alloc>
+v8::Local<v8::Value> property_key(v8::Isolate* isolate,
+	std::basic_string<char, Traits, Alloc> const& key)
+{
+	v8::Local<v8::String> result;
+	if (!v8::String::NewFromUtf8(isolate, key.data(), v8::NewStringType::kInternalized,
+		static_cast<int>(key.size())).ToLocal(&result))
+	{
+		throw std::runtime_error("can't create object property key");
+	}
+	return result;
+}
+
+} // namespace detail
+
 // convert Object <-> std::map
 template<typename Key, typename Value, typename Less, typename Alloc>
 struct convert<std::map<Key, Value, Less, Alloc>>
@@ -429,27 +1179,34 @@ struct convert<std::map<Key, Value, Less, Alloc>>
 		}
 
 		v8::HandleScope scope(isolate);
+		v8::Local<v8::Context> context = isolate->GetCurrentContext();
 		v8::Local<v8::Object> object = value.As<v8::Object>();
 		v8::Local<v8::Array> prop_names = object->GetPropertyNames();
 
 		from_type result;
-		for (uint32_t i = 0, count = prop_names->Length(); i < count; ++i)
-		{
-			v8::Local<v8::Value> key = prop_names->Get(i);
-			v8::Local<v8::Value> val = object->Get(key);
-			result.emplace(convert<Key>::from_v8(isolate, key), convert<Value>::from_v8(isolate, val));
-		}
+		detail::get_elements(isolate, prop_names, prop_names->Length(),
+			[isolate, &context, &object, &result](uint32_t, v8::Local<v8::Value> key)
+			{
+				v8::Local<v8::Value> val = detail::get_property(context, object, key);
+				result.emplace(convert<Key>::from_v8(isolate, key), convert<Value>::from_v8(isolate, val));
+			});
 		return result;
 	}
 
 	static to_type to_v8(v8::Isolate* isolate, from_type const& value)
 	{
 		v8::EscapableHandleScope scope(isolate);
+		v8::Local<v8::Context> context = isolate->GetCurrentContext();
 
 		v8::Local<v8::Object> result = v8::Object::New(isolate);
-		for (auto const& item: value)
+		for (auto it = value.begin(), end = value.end(); it != end; )
 		{
-			result->Set(convert<Key>::to_v8(isolate, item.first), convert<Value>::to_v8(isolate, item.second));
+			v8::HandleScope chunk_scope(isolate);
+			for (size_t n = 0; n < detail::conversion_chunk_size && it != end; ++n, ++it)
+			{
+				detail::set_property(context, result, detail::property_key(isolate, it->first),
+					convert<Value>::to_v8(isolate, it->second));
+			}
 		}
 		return scope.Escape(result);
 	}
@@ -558,12 +1315,21 @@ struct is_wrapped_class<v8::Persistent<T>> : std::false_type {};
 template<typename Char, typename Traits, typename Alloc>
 struct is_wrapped_class<std::basic_string<Char, Traits, Alloc>> : std::false_type {};
 
+template<>
+struct is_wrapped_class<string_view> : std::false_type {};
+
+template<typename Char>
+struct is_wrapped_class<basic_external_string<Char>> : std::false_type {};
+
 template<typename T, size_t N>
 struct is_wrapped_class<std::array<T, N>> : std::false_type{};
 
 template<typename T, typename Alloc>
 struct is_wrapped_class<std::vector<T, Alloc>> : std::false_type {};
 
+template<typename T, typename Alloc>
+struct is_wrapped_class<typed_array<T, Alloc>> : std::false_type {};
+
 template<typename Key, typename Value, typename Less, typename Alloc>
 struct is_wrapped_class<std::map<Key, Value, Less, Alloc>> : std::false_type {};
 
@@ -761,8 +1527,7 @@ struct convert_result_to_v8
 	using class_type = typename std::remove_cv<T>::type;
 	using to_type = typename convert<T>::to_type;
 	static to_type result_to_v8(v8::Isolate* isolate, from_type& value) {
-		class_type* mycopy(new class_type(std::move(value)));
-		return class_<class_type>::import_external(isolate, mycopy);
+		return class_<class_type>::import_value(isolate, std::move(value));
 	}
 };
 
@@ -773,8 +1538,32 @@ struct convert_result_to_v8
 	using class_type = typename std::remove_cv<T>::type;
 	using to_type = typename convert<T>::to_type;
 	static to_type result_to_v8(v8::Isolate* isolate, from_type& value) {
-		class_type* mycopy(new class_type(std::move(value)));
-		return class_<class_type>::import_const_external(isolate, mycopy);
+		return class_<class_type>::import_const_value(isolate, std::move(value));
+	}
+};
+
+template <typename Char>
+struct convert_result_to_v8<basic_external_string<Char>> {
+	using from_type = basic_external_string<Char>;
+	using to_type = typename convert<from_type>::to_type;
+	static to_type result_to_v8(v8::Isolate* isolate, from_type& value) {
+		return detail::new_external_string(isolate, std::move(value.str()),
+			value.get_encoding() == from_type::latin1);
+	}
+};
+
+// long strings returned by value are moved into external ones
+template <typename Char, typename Traits, typename Alloc>
+struct convert_result_to_v8<std::basic_string<Char, Traits, Alloc>> {
+	using from_type = std::basic_string<Char, Traits, Alloc>;
+	using to_type = typename convert<from_type>::to_type;
+	static to_type result_to_v8(v8::Isolate* isolate, from_type& value) {
+		if (V8PP_EXTERNAL_STRING_THRESHOLD > 0
+			&& value.size() >= size_t(V8PP_EXTERNAL_STRING_THRESHOLD))
+		{
+			return detail::new_external_string(isolate, std::move(value));
+		}
+		return convert<from_type>::to_v8(isolate, value);
 	}
 };
 
@@ -828,11 +1617,11 @@ v8::Handle<v8::Array> to_v8(v8::Isolate* isolate, Iterator begin, Iterator end)
 {
 	v8::EscapableHandleScope scope(isolate);
 
+	using value_type = typename std::iterator_traits<Iterator>::value_type;
+
 	v8::Local<v8::Array> result = v8::Array::New(isolate);
-	for (uint32_t idx = 0; begin != end; ++begin, ++idx)
-	{
-		result->Set(idx, to_v8(isolate, *begin));
-	}
+	detail::set_elements(isolate, result, begin, end,
+		[isolate](value_type const& element) { return to_v8(isolate, element); });
 	return scope.Escape(result);
 }
 
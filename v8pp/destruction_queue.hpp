@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_DESTRUCTION_QUEUE_HPP_INCLUDED
+#define V8PP_DESTRUCTION_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace v8pp {
+
+/// Counters of the deferred destruction queue of an isolate
+struct destruction_queue_stats
+{
+	size_t depth;            // objects waiting for destruction
+	size_t background_depth; // of them, handed to the background thread
+	size_t peak_depth;
+	size_t enqueued;         // objects queued in total
+	size_t destroyed;        // objects destroyed from the queue in total
+	double max_latency_ms;   // longest time from queueing to destruction
+	double avg_latency_ms;
+	double last_drain_ms;    // duration of the last drain on the isolate thread
+};
+
+namespace detail {
+
+/// Objects collected by GC waiting for destruction.
+///
+/// Weak callbacks of classes with deferred destruction unlink the object
+/// record and push the object here, instead of running the destroy
+/// function inside the GC pause. drain() destroys queued objects in
+/// batches on the isolate thread, at idle points chosen by the embedder.
+/// Objects of thread-safe classes are handed to a background thread,
+/// started with the first such object.
+class destruction_queue
+{
+public:
+	using destroy_function = void (*)(void* owner, void* object, bool pooled);
+
+	destruction_queue()
+		: peak_depth_(0)
+		, enqueued_(0)
+		, last_drain_(0)
+		, background_depth_(0)
+		, busy_(false)
+		, stop_(false)
+	{
+	}
+
+	destruction_queue(destruction_queue const&) = delete;
+	destruction_queue& operator=(destruction_queue const&) = delete;
+
+	~destruction_queue()
+	{
+		flush();
+		if (worker_.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			wakeup_.notify_one();
+			worker_.join();
+		}
+	}
+
+	/// Queue the object for destroy(owner, object, pooled) and release
+	/// of the shared pointer, whichever are set. Called on the isolate thread.
+	void push(destroy_function destroy, void* owner, void* object, bool pooled,
+		std::shared_ptr<void> shared, bool background)
+	{
+		entry e{ destroy, owner, object, pooled, std::move(shared), clock::now() };
+		if (background)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!worker_.joinable())
+				{
+					worker_ = std::thread(&destruction_queue::run, this);
+				}
+				background_.push_back(std::move(e));
+				++background_depth_;
+			}
+			wakeup_.notify_one();
+		}
+		else
+		{
+			pending_.push_back(std::move(e));
+		}
+		++enqueued_;
+		size_t const depth = pending_.size() + background_depth_;
+		if (depth > peak_depth_)
+		{
+			peak_depth_ = depth;
+		}
+	}
+
+	/// Destroy up to max_count objects queued for the isolate thread,
+	/// all of them if max_count is 0. Return the number of destroyed objects.
+	size_t drain(size_t max_count = 0)
+	{
+		clock::time_point const start = clock::now();
+		latency batch;
+		// a destructor may queue more objects, they are taken in the same drain
+		while (!pending_.empty() && (max_count == 0 || batch.count < max_count))
+		{
+			entry e = std::move(pending_.front());
+			pending_.pop_front();
+			destroy(e, batch);
+		}
+		last_drain_ = clock::now() - start;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		latency_.merge(batch);
+		return batch.count;
+	}
+
+	/// Destroy all queued objects and wait for the background thread
+	void flush()
+	{
+		drain();
+		std::unique_lock<std::mutex> lock(mutex_);
+		idle_.wait(lock, [this] { return background_.empty() && !busy_; });
+	}
+
+	size_t depth() const { return pending_.size() + background_depth_; }
+
+	destruction_queue_stats stats() const
+	{
+		using ms = std::chrono::duration<double, std::milli>;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		destruction_queue_stats result;
+		result.depth = pending_.size() + background_depth_;
+		result.background_depth = background_depth_;
+		result.peak_depth = peak_depth_;
+		result.enqueued = enqueued_;
+		result.destroyed = latency_.count;
+		result.max_latency_ms = ms(latency_.max).count();
+		result.avg_latency_ms = latency_.count?
+			ms(latency_.total).count() / latency_.count : 0.0;
+		result.last_drain_ms = ms(last_drain_).count();
+		return result;
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct entry
+	{
+		destroy_function destroy;
+		void* owner;
+		void* object;
+		bool pooled;
+		std::shared_ptr<void> shared;
+		clock::time_point queued;
+	};
+
+	struct latency
+	{
+		size_t count = 0;
+		clock::duration total = clock::duration::zero();
+		clock::duration max = clock::duration::zero();
+
+		void add(clock::duration d)
+		{
+			++count;
+			total += d;
+			if (d > max) max = d;
+		}
+
+		void merge(latency const& other)
+		{
+			count += other.count;
+			total += other.total;
+			if (other.max > max) max = other.max;
+		}
+	};
+
+	static void destroy(entry& e, latency& batch)
+	{
+		if (e.destroy)
+		{
+			e.destroy(e.owner, e.object, e.pooled);
+		}
+		e.shared.reset();
+		batch.add(clock::now() - e.queued);
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;)
+		{
+			wakeup_.wait(lock, [this] { return stop_ || !background_.empty(); });
+			if (background_.empty())
+			{
+				return;
+			}
+			std::deque<entry> batch_entries;
+			batch_entries.swap(background_);
+			busy_ = true;
+			lock.unlock();
+
+			latency batch;
+			for (entry& e : batch_entries)
+			{
+				destroy(e, batch);
+			}
+
+			lock.lock();
+			latency_.merge(batch);
+			background_depth_ -= batch_entries.size();
+			busy_ = false;
+			idle_.notify_all();
+		}
+	}
+
+	// isolate thread only
+	std::deque<entry> pending_;
+	size_t peak_depth_;
+	size_t enqueued_;
+	clock::duration last_drain_;
+
+	// shared with the background thread, guarded by mutex_
+	mutable std::mutex mutex_;
+	std::condition_variable wakeup_;
+	std::condition_variable idle_;
+	std::deque<entry> background_;
+	std::atomic<size_t> background_depth_;
+	latency latency_;
+	bool busy_;
+	bool stop_;
+	std::thread worker_;
+};
+
+}} // namespace v8pp::detail
+
+#endif // V8PP_DESTRUCTION_QUEUE_HPP_INCLUDED
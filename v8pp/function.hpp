@@ -438,6 +438,111 @@ void forward_function_called_as_nonmethod
 	}
 }
 
+/// Member function pointer bound with class_::set, stored together with
+/// the class_singleton of the bound class. Calls unwrap `this` straight
+/// through the singleton, without a class registry lookup per call. The
+/// singleton is looked up again only after some class of the isolate has
+/// been removed.
+template<typename Singleton, typename F>
+struct bound_method
+{
+	F method;
+	Singleton* singleton;
+	std::shared_ptr<size_t const> generation;
+	size_t seen_generation;
+
+	Singleton& get_singleton(v8::Isolate* isolate)
+	{
+		if (*generation != seen_generation)
+		{
+			// throws if the class has been removed
+			singleton = &Singleton::find(isolate);
+			generation = Singleton::generation(isolate);
+			seen_generation = *generation;
+		}
+		return *singleton;
+	}
+};
+
+template<typename Singleton, typename F>
+typename std::enable_if<!first_param_is_const<F>::value,
+	typename function_traits<F>::return_type>::type
+invoke_bound_method(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	using data_type = bound_method<Singleton, F>;
+	data_type& data = get_external_data<data_type>(args.Data());
+	auto obj = data.get_singleton(args.GetIsolate()).unwrap_object(args.This());
+	if (!obj)
+	{
+		throw std::runtime_error("expected C++ wrapped object");
+	}
+	return call_from_v8(*obj, data.method, args);
+}
+
+template<typename Singleton, typename F>
+typename std::enable_if<first_param_is_const<F>::value,
+	typename function_traits<F>::return_type>::type
+invoke_bound_method(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	using data_type = bound_method<Singleton, F>;
+	data_type& data = get_external_data<data_type>(args.Data());
+	auto obj = data.get_singleton(args.GetIsolate()).unwrap_const_object(args.This());
+	if (!obj)
+	{
+		throw std::runtime_error("expected C++ wrapped object");
+	}
+	return call_from_v8(*obj, data.method, args);
+}
+
+template<typename Singleton, typename F>
+typename std::enable_if<is_void_return<F>::value>::type
+forward_ret_bound_method(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	invoke_bound_method<Singleton, F>(args);
+}
+
+template<typename Singleton, typename F>
+typename std::enable_if<!is_void_return<F>::value>::type
+forward_ret_bound_method(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	args.GetReturnValue().Set(result_to_v8(args.GetIsolate(),
+		invoke_bound_method<Singleton, F>(args)));
+}
+
+template<typename Singleton, typename F>
+void forward_bound_method(v8::FunctionCallbackInfo<v8::Value> const& args)
+{
+	static_assert(std::is_member_function_pointer<F>::value,
+		"required member function pointer F");
+
+	v8::Isolate* isolate = args.GetIsolate();
+	v8::HandleScope scope(isolate);
+
+	try
+	{
+		forward_ret_bound_method<Singleton, F>(args);
+	}
+	catch (std::exception const& ex)
+	{
+		args.GetReturnValue().Set(throw_ex(isolate, ex.what()));
+	}
+}
+
+/// Wrap C++ member function into new V8 function template, unwrapping
+/// `this` with the given class singleton
+template<typename Singleton, typename F>
+v8::Handle<v8::FunctionTemplate> wrap_method_template(v8::Isolate* isolate,
+	Singleton& singleton, F method)
+{
+	using data_type = bound_method<Singleton, F>;
+	std::shared_ptr<size_t const> generation = Singleton::generation(isolate);
+	size_t const seen_generation = *generation;
+	return v8::FunctionTemplate::New(isolate,
+		&forward_bound_method<Singleton, F>,
+		set_external_data(isolate, data_type{ method, &singleton,
+			std::move(generation), seen_generation }));
+}
+
 } // namespace detail
 
 /// Wrap C++ function into new V8 function template
@@ -13,6 +13,7 @@
 
 #include "v8pp/config.hpp"
 #include "v8pp/function.hpp"
+#include "v8pp/name_cache.hpp"
 #include "v8pp/property.hpp"
 
 namespace v8pp {
@@ -43,7 +44,7 @@ public:
 	template<typename Data>
 	module& set(char const* name, v8::Handle<Data> value)
 	{
-		obj_->Set(v8pp::to_v8(isolate_, name), value);
+		obj_->Set(v8pp::name(isolate_, name), value);
 		return *this;
 	}
 
@@ -59,7 +60,7 @@ public:
 	{
 		v8::HandleScope scope(isolate_);
 
-		cl.class_function_template()->SetClassName(v8pp::to_v8(isolate_, name));
+		cl.class_function_template()->SetClassName(v8pp::name(isolate_, name));
 		return set(name, cl.js_function_template());
 	}
 
@@ -85,7 +86,7 @@ public:
 			setter = nullptr;
 		}
 
-		obj_->SetAccessor(v8pp::to_v8(isolate_, name), getter, setter,
+		obj_->SetAccessor(v8pp::name(isolate_, name), getter, setter,
 			detail::set_external_data(isolate_, &var), v8::DEFAULT,
 			v8::PropertyAttribute(v8::DontDelete | (setter ? 0 : v8::ReadOnly)));
 		return *this;
@@ -106,7 +107,7 @@ public:
 			setter = nullptr;
 		}
 
-		obj_->SetAccessor(v8pp::to_v8(isolate_, name), getter, setter,
+		obj_->SetAccessor(v8pp::name(isolate_, name), getter, setter,
 			detail::set_external_data(isolate_, std::forward<property_type>(property)),
 			v8::DEFAULT,
 			v8::PropertyAttribute(v8::DontDelete | (setter ? 0 : v8::ReadOnly)));
@@ -118,7 +119,7 @@ public:
 	{
 		v8::HandleScope scope(isolate_);
 
-		obj_->Set(v8pp::to_v8(isolate_, name), m.obj_,
+		obj_->Set(v8pp::name(isolate_, name), m.obj_,
 			v8::PropertyAttribute(v8::ReadOnly | v8::DontDelete));
 		return *this;
 	}
@@ -129,7 +130,7 @@ public:
 	{
 		v8::HandleScope scope(isolate_);
 
-		obj_->Set(v8pp::to_v8(isolate_, name), to_v8(isolate_, value),
+		obj_->Set(v8pp::name(isolate_, name), to_v8(isolate_, value),
 			v8::PropertyAttribute(v8::ReadOnly | v8::DontDelete));
 		return *this;
 	}
@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_NAME_CACHE_HPP_INCLUDED
+#define V8PP_NAME_CACHE_HPP_INCLUDED
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <v8.h>
+
+#include "v8pp/config.hpp"
+
+namespace v8pp { namespace detail {
+
+inline v8::Local<v8::String> new_name(v8::Isolate* isolate, char const* str, size_t len)
+{
+	return v8::String::NewFromUtf8(isolate, str,
+		v8::NewStringType::kInternalized, static_cast<int>(len)).ToLocalChecked();
+}
+
+/// Internalized strings of property names used in an isolate.
+///
+/// Names are looked up by content in an open addressing table, with no
+/// allocation for a name met before. Only names from the program text are
+/// cached, so the set of names is bounded. Strings are kept in
+/// persistent handles, which are reset by clear_names(isolate).
+/// The table of an isolate is in its isolate_data.
+class name_cache
+{
+public:
+	name_cache()
+		: entries_(initial_capacity)
+		, size_(0)
+	{
+	}
+
+	name_cache(name_cache const&) = delete;
+	name_cache& operator=(name_cache const&) = delete;
+
+	v8::Local<v8::String> get(v8::Isolate* isolate, char const* str, size_t len)
+	{
+		size_t const hash = hash_name(str, len);
+		size_t const mask = entries_.size() - 1;
+		for (size_t i = hash & mask;; i = (i + 1) & mask)
+		{
+			entry& e = entries_[i];
+			if (e.name.IsEmpty())
+			{
+				return insert(isolate, e, hash, str, len);
+			}
+			if (e.hash == hash && e.key.size() == len
+				&& std::memcmp(e.key.data(), str, len) == 0)
+			{
+				return e.name.Get(isolate);
+			}
+		}
+	}
+
+	size_t size() const { return size_; }
+
+	void clear()
+	{
+		std::vector<entry>(initial_capacity).swap(entries_);
+		size_ = 0;
+	}
+
+private:
+	enum { initial_capacity = 64 };
+
+	struct entry
+	{
+		size_t hash;
+		std::string key;
+		v8::Global<v8::String> name;
+	};
+
+	// FNV-1a
+	static size_t hash_name(char const* str, size_t len)
+	{
+		size_t hash = static_cast<size_t>(2166136261u);
+		for (size_t i = 0; i < len; ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619u;
+		}
+		return hash;
+	}
+
+	v8::Local<v8::String> insert(v8::Isolate* isolate, entry& e, size_t hash,
+		char const* str, size_t len)
+	{
+		v8::Local<v8::String> name = new_name(isolate, str, len);
+		e.hash = hash;
+		e.key.assign(str, len);
+		e.name.Reset(isolate, name);
+		// keep the table at most half full
+		if (++size_ * 2 > entries_.size())
+		{
+			grow();
+		}
+		return name;
+	}
+
+	void grow()
+	{
+		std::vector<entry> entries(entries_.size() * 2);
+		entries_.swap(entries);
+		size_t const mask = entries_.size() - 1;
+		for (entry& e : entries)
+		{
+			if (!e.name.IsEmpty())
+			{
+				size_t i = e.hash & mask;
+				while (!entries_[i].name.IsEmpty())
+				{
+					i = (i + 1) & mask;
+				}
+				entries_[i] = std::move(e);
+			}
+		}
+	}
+
+	std::vector<entry> entries_;
+	size_t size_;
+};
+
+#if defined(V8PP_ISOLATE_DATA_SLOT)
+
+/// Data of v8pp in an isolate, kept in its V8PP_ISOLATE_DATA_SLOT.
+///
+/// It is reached only through the isolate, with no lock, and a new isolate
+/// never sees the data of a disposed one. Handles in it are never destroyed
+/// after the isolate disposal: without cleanup(isolate) the data is leaked.
+struct isolate_data
+{
+	name_cache names;
+	// class_singletons of the isolate, managed in class.hpp
+	void* classes;
+
+	isolate_data() : classes(nullptr) {}
+
+	static isolate_data* get(v8::Isolate* isolate)
+	{
+		return static_cast<isolate_data*>(isolate->GetData(V8PP_ISOLATE_DATA_SLOT));
+	}
+
+	static isolate_data& add(v8::Isolate* isolate)
+	{
+		isolate_data* data = get(isolate);
+		if (!data)
+		{
+			data = new isolate_data;
+			isolate->SetData(V8PP_ISOLATE_DATA_SLOT, data);
+		}
+		return *data;
+	}
+
+	// Delete the data when nothing is kept in it
+	static void release(v8::Isolate* isolate)
+	{
+		isolate_data* data = get(isolate);
+		if (data && !data->classes && data->names.size() == 0)
+		{
+			delete data;
+			isolate->SetData(V8PP_ISOLATE_DATA_SLOT, nullptr);
+		}
+	}
+};
+
+#endif
+
+} // namespace detail
+
+/// Internalized V8 string for a property name from the program text, such
+/// as a literal or a member name given on registration, created once per
+/// isolate. Names are cached until cleanup(isolate) or clear_names(isolate),
+/// when V8PP_ISOLATE_DATA_SLOT is defined, and created on each call otherwise.
+inline v8::Local<v8::String> name(v8::Isolate* isolate, char const* str)
+{
+#if defined(V8PP_ISOLATE_DATA_SLOT)
+	return detail::isolate_data::add(isolate).names.get(isolate, str, std::strlen(str));
+#else
+	return detail::new_name(isolate, str, std::strlen(str));
+#endif
+}
+
+/// Internalized V8 string for a property name built at run time, not cached
+inline v8::Local<v8::String> name(v8::Isolate* isolate, char const* str, size_t len)
+{
+	return detail::new_name(isolate, str, len);
+}
+
+inline v8::Local<v8::String> name(v8::Isolate* isolate, std::string const& str)
+{
+	return detail::new_name(isolate, str.data(), str.size());
+}
+
+/// Forget cached names of the isolate
+inline void clear_names(v8::Isolate* isolate)
+{
+#if defined(V8PP_ISOLATE_DATA_SLOT)
+	if (detail::isolate_data* data = detail::isolate_data::get(isolate))
+	{
+		data->names.clear();
+		detail::isolate_data::release(isolate);
+	}
+#else
+	(void)isolate;
+#endif
+}
+
+} // namespace v8pp
+
+#endif // V8PP_NAME_CACHE_HPP_INCLUDED
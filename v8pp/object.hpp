@@ -13,9 +13,35 @@
 #include <v8.h>
 
 #include "v8pp/convert.hpp"
+#include "v8pp/name_cache.hpp"
 
 namespace v8pp {
 
+namespace detail {
+
+template<typename T>
+bool get_option(v8::Isolate* isolate, v8::Handle<v8::Object> options,
+	v8::Local<v8::String> name, T& value)
+{
+	v8::Local<v8::Value> val = options->Get(name);
+	if (val.IsEmpty() || val->IsUndefined())
+	{
+		return false;
+	}
+	value = from_v8<T>(isolate, val);
+	return true;
+}
+
+// Subobject of the options for the name prefix before the dot, which may
+// be built at run time, so its name is not cached
+inline bool get_suboptions(v8::Isolate* isolate, v8::Handle<v8::Object> options,
+	char const* name, char const* dot, v8::Local<v8::Object>& suboptions)
+{
+	return get_option(isolate, options, v8pp::name(isolate, name, dot - name), suboptions);
+}
+
+} // namespace detail
+
 /// Get optional value from V8 object by name.
 /// Dot symbols in option name delimits subobjects name.
 /// return false if the value doesn't exist in the options object
@@ -26,19 +52,12 @@ bool get_option(v8::Isolate* isolate, v8::Handle<v8::Object> options,
 	char const* dot = strchr(name, '.');
 	if (dot)
 	{
-		std::string const subname(name, dot);
 		v8::HandleScope scope(isolate);
 		v8::Local<v8::Object> suboptions;
-		return get_option(isolate, options, subname.c_str(), suboptions)
+		return detail::get_suboptions(isolate, options, name, dot, suboptions)
 			&& get_option(isolate, suboptions, dot + 1, value);
 	}
-	v8::Local<v8::Value> val = options->Get(v8pp::to_v8(isolate, name));
-	if (val.IsEmpty() || val->IsUndefined())
-	{
-		return false;
-	}
-	value = from_v8<T>(isolate, val);
-	return true;
+	return detail::get_option(isolate, options, v8pp::name(isolate, name), value);
 }
 
 /// Set named value in V8 object
@@ -51,13 +70,12 @@ bool set_option(v8::Isolate* isolate, v8::Handle<v8::Object> options,
 	char const* dot = strchr(name, '.');
 	if (dot)
 	{
-		std::string const subname(name, dot);
 		v8::HandleScope scope(isolate);
 		v8::Local<v8::Object> suboptions;
-		return get_option(isolate, options, subname.c_str(), suboptions)
+		return detail::get_suboptions(isolate, options, name, dot, suboptions)
 			&& set_option(isolate, suboptions, dot + 1, value);
 	}
-	options->Set(v8pp::to_v8(isolate, name), to_v8(isolate, value));
+	options->Set(v8pp::name(isolate, name), to_v8(isolate, value));
 	return true;
 }
 
@@ -67,7 +85,7 @@ template<typename T>
 void set_const(v8::Isolate* isolate, v8::Handle<v8::Object> options,
 	char const* name, T const& value)
 {
-	options->ForceSet(v8pp::to_v8(isolate, name), to_v8(isolate, value),
+	options->ForceSet(v8pp::name(isolate, name), to_v8(isolate, value),
 		v8::PropertyAttribute(v8::ReadOnly | v8::DontDelete));
 }
 
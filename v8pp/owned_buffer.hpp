@@ -0,0 +1,370 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_OWNED_BUFFER_HPP_INCLUDED
+#define V8PP_OWNED_BUFFER_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <v8.h>
+
+#include "v8pp/convert.hpp"
+
+namespace v8pp {
+
+/// Binary data handed to V8 as an ArrayBuffer without a copy.
+///
+/// The buffer takes ownership of a vector, a unique_ptr array or any
+/// memory with a free function. Returned from a wrapped function, the
+/// memory becomes the backing store of an external ArrayBuffer. It is
+/// freed when the ArrayBuffer is collected, and its size is reported to V8
+/// as external memory until then.
+class owned_buffer
+{
+public:
+	using free_function = void (*)(void* data, void* hint);
+
+	owned_buffer()
+		: data_(nullptr), size_(0), free_(nullptr), hint_(nullptr)
+	{
+	}
+
+	/// Own memory to free with free_fn(data, hint)
+	owned_buffer(void* data, size_t size, free_function free_fn, void* hint = nullptr)
+		: data_(data), size_(size), free_(free_fn), hint_(hint)
+	{
+	}
+
+	owned_buffer(std::unique_ptr<uint8_t[]> data, size_t size)
+		: data_(data.release()), size_(size), free_(&free_array), hint_(nullptr)
+	{
+	}
+
+	/// Own vector of numbers or other trivially copyable elements
+	template<typename T, typename Alloc>
+	owned_buffer(std::vector<T, Alloc>&& vec)
+		: data_(nullptr), size_(0), free_(nullptr), hint_(nullptr)
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+			"vector elements must be trivially copyable");
+		std::unique_ptr<std::vector<T, Alloc>> owner(new std::vector<T, Alloc>(std::move(vec)));
+		data_ = owner->data();
+		size_ = owner->size() * sizeof(T);
+		free_ = &free_vector<T, Alloc>;
+		hint_ = owner.release();
+	}
+
+	owned_buffer(owned_buffer&& src)
+		: data_(src.data_), size_(src.size_), free_(src.free_), hint_(src.hint_)
+	{
+		src.data_ = nullptr;
+		src.size_ = 0;
+		src.free_ = nullptr;
+		src.hint_ = nullptr;
+	}
+
+	owned_buffer& operator=(owned_buffer&& src)
+	{
+		if (this != &src)
+		{
+			reset();
+			std::swap(data_, src.data_);
+			std::swap(size_, src.size_);
+			std::swap(free_, src.free_);
+			std::swap(hint_, src.hint_);
+		}
+		return *this;
+	}
+
+	owned_buffer(owned_buffer const&) = delete;
+	owned_buffer& operator=(owned_buffer const&) = delete;
+
+	~owned_buffer()
+	{
+		reset();
+	}
+
+	void* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	/// Free the memory
+	void reset()
+	{
+		if (free_)
+		{
+			free_(data_, hint_);
+		}
+		data_ = nullptr;
+		size_ = 0;
+		free_ = nullptr;
+		hint_ = nullptr;
+	}
+
+private:
+	static void free_array(void* data, void*)
+	{
+		delete[] static_cast<uint8_t*>(data);
+	}
+
+	template<typename T, typename Alloc>
+	static void free_vector(void*, void* hint)
+	{
+		delete static_cast<std::vector<T, Alloc>*>(hint);
+	}
+
+	void* data_;
+	size_t size_;
+	free_function free_;
+	void* hint_;
+};
+
+namespace detail {
+
+/// External ArrayBuffers of an isolate backed by owned buffers.
+///
+/// A weak handle frees the memory when the ArrayBuffer is collected.
+/// Buffers alive at release_buffers(isolate) are freed there, since weak
+/// callbacks are not called on isolate disposal.
+class external_buffers
+{
+public:
+	external_buffers() : head_(nullptr), count_(0), bytes_(0) {}
+
+	static v8::Local<v8::ArrayBuffer> create(v8::Isolate* isolate, owned_buffer&& data)
+	{
+		v8::Local<v8::ArrayBuffer> result = v8::ArrayBuffer::New(isolate,
+			data.data(), data.size(), v8::ArrayBufferCreationMode::kExternalized);
+
+		external_buffers& buffers = *instance(add, isolate);
+		buffer* buf = new buffer(std::move(data));
+		buf->handle.Reset(isolate, result);
+		buf->handle.SetWeak(buf, &on_collected, v8::WeakCallbackType::kParameter);
+		buffers.link(buf);
+		isolate->AdjustAmountOfExternalAllocatedMemory(
+			static_cast<int64_t>(buf->data.size()));
+		return result;
+	}
+
+	/// Free all buffers of the isolate. ArrayBuffers still alive are
+	/// neutered first and the memory is reported back, unless the isolate
+	/// is disposed next and no script runs in it any more.
+	static void release_all(v8::Isolate* isolate, bool neuter = true)
+	{
+		external_buffers* buffers = instance(get, isolate);
+		if (!buffers)
+		{
+			return;
+		}
+		int64_t released = 0;
+		while (buffer* buf = buffers->head_)
+		{
+			if (neuter)
+			{
+				v8::HandleScope scope(isolate);
+				v8::Local<v8::ArrayBuffer> array = buf->handle.Get(isolate);
+				if (array->IsNeuterable())
+				{
+					array->Neuter();
+				}
+			}
+			released += static_cast<int64_t>(buf->data.size());
+			buffers->unlink(buf);
+			delete buf;
+		}
+		if (neuter)
+		{
+			isolate->AdjustAmountOfExternalAllocatedMemory(-released);
+		}
+		instance(remove, isolate);
+	}
+
+	/// Number and total size of live buffers in the isolate
+	static size_t count(v8::Isolate* isolate)
+	{
+		external_buffers* buffers = instance(get, isolate);
+		return buffers? buffers->count_ : 0;
+	}
+
+	static size_t bytes(v8::Isolate* isolate)
+	{
+		external_buffers* buffers = instance(get, isolate);
+		return buffers? buffers->bytes_ : 0;
+	}
+
+private:
+	struct buffer
+	{
+		explicit buffer(owned_buffer&& data)
+			: data(std::move(data)), prev(nullptr), next(nullptr)
+		{
+		}
+
+		owned_buffer data;
+		v8::Global<v8::ArrayBuffer> handle;
+		buffer* prev;
+		buffer* next;
+	};
+
+	static void on_collected(v8::WeakCallbackInfo<buffer> const& data)
+	{
+		v8::Isolate* isolate = data.GetIsolate();
+		buffer* buf = data.GetParameter();
+		int64_t const size = static_cast<int64_t>(buf->data.size());
+		if (external_buffers* buffers = instance(get, isolate))
+		{
+			buffers->unlink(buf);
+		}
+		delete buf;
+		isolate->AdjustAmountOfExternalAllocatedMemory(-size);
+	}
+
+	void link(buffer* buf)
+	{
+		buf->next = head_;
+		if (head_)
+		{
+			head_->prev = buf;
+		}
+		head_ = buf;
+		++count_;
+		bytes_ += buf->data.size();
+	}
+
+	void unlink(buffer* buf)
+	{
+		if (buf->prev)
+		{
+			buf->prev->next = buf->next;
+		}
+		else
+		{
+			head_ = buf->next;
+		}
+		if (buf->next)
+		{
+			buf->next->prev = buf->prev;
+		}
+		--count_;
+		bytes_ -= buf->data.size();
+	}
+
+	enum operation { get, add, remove };
+
+	// buffers of an isolate are used only on the isolate thread
+	static external_buffers* instance(operation op, v8::Isolate* isolate)
+	{
+		static std::unordered_map<v8::Isolate*, external_buffers> instances;
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
+		switch (op)
+		{
+		case get:
+			{
+				auto it = instances.find(isolate);
+				return it != instances.end()? &it->second : nullptr;
+			}
+		case add:
+			return &instances[isolate];
+		case remove:
+			instances.erase(isolate);
+		default:
+			return nullptr;
+		}
+	}
+
+	buffer* head_;
+	size_t count_;
+	size_t bytes_;
+};
+
+} // namespace detail
+
+/// Free owned buffers of the isolate and neuter their ArrayBuffers still
+/// alive. cleanup(isolate) calls it, teardown(isolate) frees the buffers
+/// without neutering. One of them is required before the isolate disposal,
+/// unless the isolate is used by a v8pp::context, which calls it on
+/// destruction.
+inline void release_buffers(v8::Isolate* isolate)
+{
+	detail::external_buffers::release_all(isolate);
+}
+
+// ArrayBuffer or its view <-> owned_buffer, result returned by value
+// is moved, others are copied once
+template<>
+struct convert<owned_buffer>
+{
+	using from_type = owned_buffer;
+	using to_type = v8::Handle<v8::ArrayBuffer>;
+
+	static bool is_valid(v8::Isolate*, v8::Handle<v8::Value> value)
+	{
+		return !value.IsEmpty() && (value->IsArrayBuffer() || value->IsArrayBufferView());
+	}
+
+	static from_type from_v8(v8::Isolate* isolate, v8::Handle<v8::Value> value)
+	{
+		if (!is_valid(isolate, value))
+		{
+			throw std::invalid_argument("expected ArrayBuffer");
+		}
+
+		std::vector<uint8_t> bytes;
+		if (value->IsArrayBufferView())
+		{
+			v8::Local<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+			bytes.resize(view->ByteLength());
+			if (!bytes.empty())
+			{
+				view->CopyContents(bytes.data(), bytes.size());
+			}
+		}
+		else
+		{
+			v8::ArrayBuffer::Contents contents = value.As<v8::ArrayBuffer>()->GetContents();
+			uint8_t const* data = static_cast<uint8_t const*>(contents.Data());
+			bytes.assign(data, data + (data? contents.ByteLength() : 0));
+		}
+		return from_type(std::move(bytes));
+	}
+
+	static to_type to_v8(v8::Isolate* isolate, from_type const& value)
+	{
+		v8::Local<v8::ArrayBuffer> result = v8::ArrayBuffer::New(isolate, value.size());
+		if (value.size())
+		{
+			std::memcpy(result->GetContents().Data(), value.data(), value.size());
+		}
+		return result;
+	}
+};
+
+template<>
+struct is_wrapped_class<owned_buffer> : std::false_type {};
+
+template<>
+struct convert_result_to_v8<owned_buffer>
+{
+	using from_type = owned_buffer;
+	using to_type = convert<owned_buffer>::to_type;
+	static to_type result_to_v8(v8::Isolate* isolate, from_type& value)
+	{
+		return detail::external_buffers::create(isolate, std::move(value));
+	}
+};
+
+} // namespace v8pp
+
+#endif // V8PP_OWNED_BUFFER_HPP_INCLUDED
@@ -0,0 +1,276 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_PTR_MAP_HPP_INCLUDED
+#define V8PP_PTR_MAP_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace v8pp { namespace detail {
+
+/// Hash map with pointer keys for the wrapped objects registry.
+///
+/// Open addressing with linear probing and robin hood ordering: probe
+/// lengths stay short up to a high load factor and a lookup stops as soon
+/// as it meets a slot closer to its home than the probe. Keys and probe
+/// lengths live in one contiguous array, values in a parallel one, so a
+/// lookup touches a single cache line in the common case and no memory
+/// is allocated per element. Erase uses backward shift, no tombstones.
+///
+/// Pointers returned by find() and emplace() are invalidated by any
+/// subsequent emplace(), erase(), reserve() or clear().
+template<typename Value>
+class ptr_map
+{
+public:
+	using key_type = void const*;
+	using mapped_type = Value;
+
+	ptr_map()
+		: size_(0)
+		, mask_(0)
+	{
+	}
+
+	ptr_map(ptr_map const&) = delete;
+	ptr_map& operator=(ptr_map const&) = delete;
+
+	~ptr_map() { clear(); }
+
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	size_t capacity() const { return slots_.size(); }
+
+	/// Find a value by key, return nullptr if there is no such key
+	Value* find(key_type key)
+	{
+		size_t const pos = find_pos(key);
+		return pos != npos? &values_[pos].value() : nullptr;
+	}
+
+	Value const* find(key_type key) const
+	{
+		size_t const pos = find_pos(key);
+		return pos != npos? &values_[pos].value() : nullptr;
+	}
+
+	/// Insert a value constructed from args if there is no such key.
+	/// Return the value for the key and true if it has been inserted.
+	template<typename ...Args>
+	std::pair<Value*, bool> emplace(key_type key, Args&&... args)
+	{
+		if (Value* existing = find(key))
+		{
+			return std::make_pair(existing, false);
+		}
+		if ((size_ + 1) * 8 > slots_.size() * 7)
+		{
+			rehash(slots_.empty()? min_capacity : slots_.size() * 2);
+		}
+		Value value(std::forward<Args>(args)...);
+		return std::make_pair(insert_new(key, std::move(value)), true);
+	}
+
+	/// Erase the value with the key, return false if there is no such key
+	bool erase(key_type key)
+	{
+		size_t pos = find_pos(key);
+		if (pos == npos)
+		{
+			return false;
+		}
+		values_[pos].destroy();
+		for (size_t next = (pos + 1) & mask_; slots_[next].dist > 1;
+			pos = next, next = (next + 1) & mask_)
+		{
+			slots_[pos].key = slots_[next].key;
+			slots_[pos].dist = slots_[next].dist - 1;
+			values_[pos].construct(std::move(values_[next].value()));
+			values_[next].destroy();
+		}
+		slots_[pos].dist = 0;
+		--size_;
+		return true;
+	}
+
+	/// Make room for count elements without rehashing
+	void reserve(size_t count)
+	{
+		size_t capacity = slots_.empty()? min_capacity : slots_.size();
+		while (count * 8 > capacity * 7)
+		{
+			capacity *= 2;
+		}
+		if (capacity > slots_.size())
+		{
+			rehash(capacity);
+		}
+	}
+
+	/// Destroy all values, keep allocated storage
+	void clear()
+	{
+		for (size_t pos = 0; pos < slots_.size(); ++pos)
+		{
+			if (slots_[pos].dist)
+			{
+				values_[pos].destroy();
+				slots_[pos].dist = 0;
+			}
+		}
+		size_ = 0;
+	}
+
+	/// Call f(key, value) for each element
+	template<typename F>
+	void for_each(F&& f)
+	{
+		for (size_t pos = 0; pos < slots_.size(); ++pos)
+		{
+			if (slots_[pos].dist)
+			{
+				f(slots_[pos].key, values_[pos].value());
+			}
+		}
+	}
+
+	template<typename F>
+	void for_each(F&& f) const
+	{
+		for (size_t pos = 0; pos < slots_.size(); ++pos)
+		{
+			if (slots_[pos].dist)
+			{
+				f(slots_[pos].key, values_[pos].value());
+			}
+		}
+	}
+
+private:
+	static size_t const npos = ~size_t(0);
+	static size_t const min_capacity = 16;
+
+	struct slot
+	{
+		key_type key;
+		// probe length + 1, 0 for an empty slot
+		uint32_t dist;
+	};
+
+	struct value_storage
+	{
+		typename std::aligned_storage<sizeof(Value), alignof(Value)>::type data;
+
+		Value& value() { return *reinterpret_cast<Value*>(&data); }
+		Value const& value() const { return *reinterpret_cast<Value const*>(&data); }
+
+		void construct(Value&& value) { new (&data) Value(std::move(value)); }
+		void destroy() { value().~Value(); }
+	};
+
+	static size_t hash(key_type key)
+	{
+		// 64-bit finalizer from MurmurHash3, spreads the aligned low bits
+		uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return static_cast<size_t>(h);
+	}
+
+	size_t find_pos(key_type key) const
+	{
+		if (size_ == 0)
+		{
+			return npos;
+		}
+		size_t pos = hash(key) & mask_;
+		for (uint32_t dist = 1; ; ++dist, pos = (pos + 1) & mask_)
+		{
+			slot const& s = slots_[pos];
+			if (s.dist < dist)
+			{
+				return npos;
+			}
+			if (s.key == key)
+			{
+				return pos;
+			}
+		}
+	}
+
+	// Insert a key known to be absent, storage must have a free slot
+	Value* insert_new(key_type key, Value&& value)
+	{
+		Value* result = nullptr;
+		uint32_t dist = 1;
+		for (size_t pos = hash(key) & mask_; ; ++dist, pos = (pos + 1) & mask_)
+		{
+			slot& s = slots_[pos];
+			if (s.dist == 0)
+			{
+				s.key = key;
+				s.dist = dist;
+				values_[pos].construct(std::move(value));
+				++size_;
+				return result? result : &values_[pos].value();
+			}
+			if (s.dist < dist)
+			{
+				// take the slot from a richer element and carry it further
+				std::swap(s.key, key);
+				std::swap(s.dist, dist);
+				std::swap(values_[pos].value(), value);
+				if (!result)
+				{
+					result = &values_[pos].value();
+				}
+			}
+		}
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<slot> old_slots(capacity, slot{ nullptr, 0 });
+		std::unique_ptr<value_storage[]> old_values(new value_storage[capacity]);
+		old_slots.swap(slots_);
+		old_values.swap(values_);
+		mask_ = capacity - 1;
+		size_ = 0;
+
+		for (size_t pos = 0; pos < old_slots.size(); ++pos)
+		{
+			if (old_slots[pos].dist)
+			{
+				insert_new(old_slots[pos].key, std::move(old_values[pos].value()));
+				old_values[pos].destroy();
+			}
+		}
+	}
+
+	std::vector<slot> slots_;
+	std::unique_ptr<value_storage[]> values_;
+	size_t size_;
+	size_t mask_;
+};
+
+template<typename Value>
+size_t const ptr_map<Value>::npos;
+
+template<typename Value>
+size_t const ptr_map<Value>::min_capacity;
+
+}} // namespace v8pp::detail
+
+#endif // V8PP_PTR_MAP_HPP_INCLUDED
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2013-2016 Pavel Medvedev. All rights reserved.
+//
+// This file is part of v8pp (https://github.com/pmed/v8pp) project.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#ifndef V8PP_SLAB_POOL_HPP_INCLUDED
+#define V8PP_SLAB_POOL_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace v8pp { namespace detail {
+
+/// Type with the strictest fundamental alignment, as std::max_align_t
+/// which is missing in the GCC 4.8 standard library
+union max_align
+{
+	long double ld;
+	long long ll;
+	double d;
+	void* p;
+	void (*f)();
+};
+
+/// Allocator of fixed size memory blocks for wrapped objects.
+///
+/// Blocks are carved from slabs of about 64 KiB and recycled through
+/// an intrusive free list, so allocate() and deallocate() are a couple
+/// of pointer moves. Slabs are released only with the pool itself, and
+/// only if no block is in use then.
+/// Blocks are aligned as max_align.
+class slab_pool
+{
+public:
+	/// Alignment of all blocks
+	enum : size_t { alignment = alignof(max_align) };
+
+	/// Round size up to the size class served by one pool
+	static size_t size_class(size_t size)
+	{
+		size_t const align = alignment;
+		if (size < sizeof(free_block))
+		{
+			size = sizeof(free_block);
+		}
+		return (size + align - 1) / align * align;
+	}
+
+	explicit slab_pool(size_t size)
+		: block_size_(size_class(size))
+		, blocks_per_slab_(slab_bytes / block_size_ > min_blocks_per_slab?
+			slab_bytes / block_size_ : min_blocks_per_slab)
+		, free_(nullptr)
+		, allocated_(0)
+	{
+	}
+
+	slab_pool(slab_pool const&) = delete;
+	slab_pool& operator=(slab_pool const&) = delete;
+
+	~slab_pool()
+	{
+		assert(allocated_ == 0 && "pooled objects are still alive");
+		if (allocated_ != 0)
+		{
+			// leak the slabs rather than leave live objects in freed memory
+			for (std::unique_ptr<char[]>& slab : slabs_)
+			{
+				slab.release();
+			}
+		}
+	}
+
+	size_t block_size() const { return block_size_; }
+
+	/// Number of blocks in use
+	size_t allocated() const { return allocated_; }
+
+	/// Number of blocks in all slabs
+	size_t capacity() const { return slabs_.size() * blocks_per_slab_; }
+
+	void* allocate()
+	{
+		if (!free_)
+		{
+			add_slab();
+		}
+		free_block* block = free_;
+		free_ = block->next;
+		++allocated_;
+		return block;
+	}
+
+	void deallocate(void* ptr)
+	{
+		assert(allocated_ > 0);
+		free_block* block = static_cast<free_block*>(ptr);
+		block->next = free_;
+		free_ = block;
+		--allocated_;
+	}
+
+private:
+	enum : size_t { slab_bytes = 64 * 1024, min_blocks_per_slab = 16 };
+
+	struct free_block
+	{
+		free_block* next;
+	};
+
+	void add_slab()
+	{
+		// operator new returns memory aligned for any fundamental type
+		std::unique_ptr<char[]> slab(new char[block_size_ * blocks_per_slab_]);
+		char* const begin = slab.get();
+		for (size_t i = blocks_per_slab_; i > 0; --i)
+		{
+			free_block* block = reinterpret_cast<free_block*>(begin + (i - 1) * block_size_);
+			block->next = free_;
+			free_ = block;
+		}
+		slabs_.emplace_back(std::move(slab));
+	}
+
+	size_t const block_size_;
+	size_t const blocks_per_slab_;
+	free_block* free_;
+	size_t allocated_;
+	std::vector<std::unique_ptr<char[]>> slabs_;
+};
+
+}} // namespace v8pp::detail
+
+#endif // V8PP_SLAB_POOL_HPP_INCLUDED
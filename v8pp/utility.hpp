@@ -9,7 +9,12 @@
 #ifndef V8PP_UTILITY_HPP_INCLUDED
 #define V8PP_UTILITY_HPP_INCLUDED
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <tuple>
+#include <utility>
 #include <type_traits>
 #include <assert.h>
 
@@ -171,6 +176,29 @@ template<typename F>
 using is_callable = std::integral_constant<bool,
 	is_callable_impl<F, std::is_class<F>::value>::value>;
 
+// Base is a public unambiguous virtual base of Derived, or is reached
+// through one: pointer to Derived converts to pointer to Base, but pointer
+// to Base can not be static_cast back to pointer to Derived
+template<typename Base, typename Derived>
+struct is_virtual_base_of_impl
+{
+private:
+	template<typename B, typename D>
+	static std::false_type test(decltype(static_cast<D*>(std::declval<B*>()))*);
+
+	template<typename, typename>
+	static std::true_type test(...);
+
+	using type = decltype(test<Base, Derived>(nullptr));
+public:
+	static const bool value = std::is_base_of<Base, Derived>::value
+		&& std::is_convertible<Derived*, Base*>::value && type::value;
+};
+
+template<typename Base, typename Derived>
+using is_virtual_base_of = std::integral_constant<bool,
+	is_virtual_base_of_impl<Base, Derived>::value>;
+
 #if (__cplusplus > 201402L) || (defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 190023918)
 using std::index_sequence;
 using std::make_index_sequence;
@@ -254,37 +282,73 @@ struct is_nonconst_member_function_pointer<R(C::*)(Args...)> :
 	std::true_type {};
 
 
-/// Type information for custom RTTI
+/// Dense sequential index for types, used for per-isolate lookup tables
+inline size_t next_type_index()
+{
+	static std::atomic<size_t> counter(0);
+	return counter++;
+}
+
+/// Type information for custom RTTI.
+/// type_id<T>() of a module is compared by address. Otherwise comparison
+/// rejects different types by a 64-bit FNV-1a hash of the name computed
+/// once per type, and compares the names only on a hash match, so T has
+/// the same identity in every module (plugins included).
+/// The index is dense and unique within a module, but a type may get
+/// different indices in different modules, so users of index() must
+/// verify the match with operator==.
 class type_info
 {
 public:
 	std::string const& name() const { return name_; }
-	bool operator==(type_info const& other) const { return name_ == other.name_; }
-	bool operator!=(type_info const& other) const { return name_ != other.name_; }
+	uint64_t id() const { return id_; }
+	size_t index() const { return index_; }
+	bool operator==(type_info const& other) const
+	{
+		// the same type_id<T>() in a module, names compared across modules
+		return this == &other || (id_ == other.id_ && name_ == other.name_);
+	}
+	bool operator!=(type_info const& other) const { return !(*this == other); }
 private:
-	template<typename T> friend type_info type_id();
+	template<typename T> friend type_info make_type_info();
 	type_info(char const* name, size_t size)
 		: name_(name, size)
+		, id_(name_hash(name, size))
+		, index_(next_type_index())
+	{
+	}
+
+	static uint64_t name_hash(char const* name, size_t size)
 	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<unsigned char>(name[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
 	}
+
 	std::string name_;
+	uint64_t id_;
+	size_t index_;
 };
 
-/// Get type information for type T
+/// Build type information for type T from the compiler pretty function name
 /// Idea  borrowed from https://github.com/Manu343726/ctti
 template<typename T>
-type_info type_id()
+type_info make_type_info()
 {
 #if defined(_MSC_VER)
 	#define V8PP_PRETTY_FUNCTION __FUNCSIG__
-	#define V8PP_PRETTY_FUNCTION_PREFIX "class v8pp::detail::type_info __cdecl v8pp::detail::type_id<"
+	#define V8PP_PRETTY_FUNCTION_PREFIX "class v8pp::detail::type_info __cdecl v8pp::detail::make_type_info<"
 	#define V8PP_PRETTY_FUNCTION_SUFFIX ">(void)"
 #elif defined(__clang__) || defined(__GNUC__)
 	#define V8PP_PRETTY_FUNCTION __PRETTY_FUNCTION__
 	#if !defined(__clang__)
-		#define V8PP_PRETTY_FUNCTION_PREFIX "v8pp::detail::type_info v8pp::detail::type_id() [with T = "
+		#define V8PP_PRETTY_FUNCTION_PREFIX "v8pp::detail::type_info v8pp::detail::make_type_info() [with T = "
 	#else
-		#define V8PP_PRETTY_FUNCTION_PREFIX "v8pp::detail::type_info v8pp::detail::type_id() [T = "
+		#define V8PP_PRETTY_FUNCTION_PREFIX "v8pp::detail::type_info v8pp::detail::make_type_info() [T = "
 	#endif
 	#define V8PP_PRETTY_FUNCTION_SUFFIX "]"
 #else
@@ -310,10 +374,18 @@ type_info type_id()
 
 #undef V8PP_PRETTY_FUNCTION
 #undef V8PP_PRETTY_FUNCTION_PREFIX
-#undef V8PP_PRETTY_FUNCTION_SUFFFIX
+#undef V8PP_PRETTY_FUNCTION_SUFFIX
 #undef V8PP_PRETTY_FUNCTION_LEN
 #undef V8PP_PRETTY_FUNCTION_PREFIX_LEN
-#undef V8PP_PRETTY_FUNCTION_SUFFFIX_LEN
+#undef V8PP_PRETTY_FUNCTION_SUFFIX_LEN
+}
+
+/// Get type information for type T, built once on the first call
+template<typename T>
+type_info const& type_id()
+{
+	static type_info const info = make_type_info<T>();
+	return info;
 }
 
 }} // namespace v8pp::detail